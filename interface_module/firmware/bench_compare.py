@@ -0,0 +1,54 @@
+#!/usr/bin/env python3
+
+"""
+Compare two parser benchmark result files written by the native simulator.
+
+Usage:
+    .pio/build/native/program --bench --out before.json
+    # ... change code, rebuild ...
+    .pio/build/native/program --bench --out after.json
+    python bench_compare.py before.json after.json
+"""
+
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    return {r["mix"]: r for r in data["results"]}
+
+
+def change(old, new):
+    if old == 0:
+        return "n/a"
+    return f"{(new - old) / old * 100:+.1f}%"
+
+
+def main():
+    if len(sys.argv) != 3:
+        print(__doc__)
+        return 2
+
+    before = load(sys.argv[1])
+    after = load(sys.argv[2])
+
+    print(f"{'mix':<16} {'ns/cmd before':>14} {'ns/cmd after':>13} {'change':>8} "
+          f"{'allocs before':>14} {'allocs after':>13}")
+    for mix in before:
+        if mix not in after:
+            print(f"{mix:<16} (missing in {sys.argv[2]})")
+            continue
+        b, a = before[mix], after[mix]
+        print(f"{mix:<16} {b['nsPerCommand']:>14.1f} {a['nsPerCommand']:>13.1f} "
+              f"{change(b['nsPerCommand'], a['nsPerCommand']):>8} "
+              f"{b['allocsPerCommand']:>14.3f} {a['allocsPerCommand']:>13.3f}")
+    for mix in after:
+        if mix not in before:
+            print(f"{mix:<16} (new)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
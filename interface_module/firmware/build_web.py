@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+
+"""
+Web asset build script for ESP32 Antenna Switch
+Gzips everything under data/ into the SPIFFS image directory and writes
+the ETag of each file to etags.txt. The same files go into web_assets.h as
+byte arrays, served from flash by builds with -DWEB_ASSETS_EMBEDDED.
+"""
+
+Import("env")
+import gzip
+import hashlib
+import os
+import re
+import shutil
+
+project_dir = env.subst("$PROJECT_DIR")
+source_dir = os.path.join(project_dir, "data")
+output_dir = os.path.join(env.subst("$PROJECT_WORKSPACE_DIR"), "data_gz")
+# Kept apart from output_dir so the header is not packed into SPIFFS
+include_dir = os.path.join(env.subst("$PROJECT_WORKSPACE_DIR"), "web_include")
+
+# Assets the pages link to; their links get ?v=<hash> so browsers may
+# cache them for a year and still load a new version at once
+VERSIONED = (".css", ".js")
+LINK = re.compile(r'(href|src)="(/[^"?]+)"')
+
+
+def content_hash(data):
+    return hashlib.sha256(data).hexdigest()[:16]
+
+
+def write_embedded_header(assets):
+    lines = [
+        "// Generated by build_web.py from data/, do not edit",
+        "#ifndef WEB_ASSETS_H",
+        "#define WEB_ASSETS_H",
+        "",
+        "#include <stddef.h>",
+        "#include <stdint.h>",
+        "",
+        "// Gzipped file, sent as is with Content-Encoding: gzip",
+        "struct EmbeddedAsset {",
+        "  const char* path;",
+        "  const uint8_t* data;",
+        "  size_t length;",
+        "  const char* etag;",
+        "};",
+        "",
+    ]
+    for i, (name, compressed, etag) in enumerate(assets):
+        lines.append(f"// /{name}")
+        lines.append(f"static constexpr uint8_t webAsset{i}[] = {{")
+        for row in range(0, len(compressed), 16):
+            lines.append("  " + ", ".join(f"0x{b:02x}" for b in compressed[row:row + 16]) + ",")
+        lines.append("};")
+        lines.append("")
+
+    lines.append("static constexpr EmbeddedAsset embeddedAssets[] = {")
+    for i, (name, compressed, etag) in enumerate(assets):
+        lines.append(f'  {{"/{name}", webAsset{i}, sizeof(webAsset{i}), "\\"{etag}\\""}},')
+    lines.append("};")
+    lines.append("")
+    lines.append(f"static constexpr size_t embeddedAssetCount = {len(assets)};")
+    lines.append("")
+    lines.append("#endif")
+
+    os.makedirs(include_dir, exist_ok=True)
+    header = os.path.join(include_dir, "web_assets.h")
+    content = "\n".join(lines) + "\n"
+    # Rewritten only on change, so an unchanged UI does not rebuild web_server.cpp
+    if os.path.exists(header):
+        with open(header) as f:
+            if f.read() == content:
+                return
+    with open(header, "w") as f:
+        f.write(content)
+
+
+def build_web_assets():
+    names = sorted(n for n in os.listdir(source_dir)
+                   if os.path.isfile(os.path.join(source_dir, n)))
+    sources = {}
+    for name in names:
+        with open(os.path.join(source_dir, name), "rb") as f:
+            sources[name] = f.read()
+
+    versions = {"/" + n: content_hash(d) for n, d in sources.items() if n.endswith(VERSIONED)}
+
+    def version_link(match):
+        path = match.group(2)
+        if path not in versions:
+            return match.group(0)
+        return f'{match.group(1)}="{path}?v={versions[path]}"'
+
+    shutil.rmtree(output_dir, ignore_errors=True)
+    os.makedirs(output_dir)
+
+    etags = []
+    assets = []
+    raw_total = 0
+    gz_total = 0
+    for name in names:
+        data = sources[name]
+        if name.endswith(".html"):
+            data = LINK.sub(version_link, data.decode("utf-8")).encode("utf-8")
+
+        # mtime=0 so an unchanged file gives the same bytes and ETag
+        compressed = gzip.compress(data, compresslevel=9, mtime=0)
+        with open(os.path.join(output_dir, name + ".gz"), "wb") as f:
+            f.write(compressed)
+
+        etag = content_hash(compressed)
+        etags.append(f'/{name} "{etag}"')
+        assets.append((name, compressed, etag))
+        raw_total += len(data)
+        gz_total += len(compressed)
+
+    with open(os.path.join(output_dir, "etags.txt"), "w") as f:
+        f.write("\n".join(etags) + "\n")
+    write_embedded_header(assets)
+
+    print(f"🗜️  Web assets: {len(names)} files, {raw_total} -> {gz_total} bytes gzipped")
+
+
+build_web_assets()
+
+# buildfs/uploadfs pack the gzipped copy instead of data/
+env.Replace(PROJECT_DATA_DIR=output_dir)
+env.Append(CPPPATH=[include_dir])
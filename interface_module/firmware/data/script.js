@@ -27,6 +27,9 @@ class AntennaSwitch {
         this.antennas = [];
         this.currentState = { radio1: 0, radio2: 0 };
         this.operationMode = { antennaSwapping: false, singleRadioMode: false };
+        // Last state version seen, sent on reconnect to get only changes
+        this.syncEpoch = null;
+        this.syncVersion = 0;
         
         this.init();
     }
@@ -89,7 +92,7 @@ class AntennaSwitch {
         namesCol.querySelectorAll('.antenna-name:not(:first-of-type)').forEach(el => el.remove());
         radio2Col.querySelectorAll('.antenna-btn:not(.disconnected)').forEach(el => el.remove());
 
-        for (let i = 1; i <= 6; i++) {
+        for (let i = 1; i <= this.antennas.length; i++) {
             const antenna = this.antennas[i - 1];
             if (!antenna || !antenna.name || antenna.name.trim() === '') continue;
 
@@ -153,7 +156,10 @@ class AntennaSwitch {
 
     connectWebSocket() {
         const protocol = window.location.protocol === 'https:' ? 'wss:' : 'ws:';
-        const wsUrl = `${protocol}//${window.location.hostname}:81`;
+        let wsUrl = `${protocol}//${window.location.host}/ws`;
+        if (this.syncEpoch !== null) {
+            wsUrl += `?epoch=${this.syncEpoch}&version=${this.syncVersion}`;
+        }
         
         this.ws = new WebSocket(wsUrl);
         
@@ -169,13 +175,19 @@ class AntennaSwitch {
         this.ws.onmessage = (event) => {
             try {
                 const data = JSON.parse(event.data);
-                if (data.type === 'state') {
-                    // Update operation mode if received
+                if (data.type === 'state' || data.type === 'delta') {
+                    // A delta carries only the fields that changed
                     if (data.hasOwnProperty('singleRadioMode')) {
                         this.operationMode.singleRadioMode = data.singleRadioMode;
                         this.updateSingleRadioMode();
                     }
-                    this.updateState(data.radio1, data.radio2);
+                    if (data.hasOwnProperty('antennaSwapping')) {
+                        this.operationMode.antennaSwapping = data.antennaSwapping;
+                    }
+                    this.updateState(
+                        data.hasOwnProperty('radio1') ? data.radio1 : this.currentState.radio1,
+                        data.hasOwnProperty('radio2') ? data.radio2 : this.currentState.radio2);
+                    this.trackVersion(data);
                 } else if (data.type === 'antennaNames') {
                     this.updateAntennaNames(data.antennas);
                 }
@@ -196,6 +208,15 @@ class AntennaSwitch {
         };
     }
 
+    trackVersion(data) {
+        if (data.epoch !== this.syncEpoch) {
+            this.syncEpoch = data.epoch;
+            this.syncVersion = data.version;
+        } else {
+            this.syncVersion = Math.max(this.syncVersion, data.version);
+        }
+    }
+
     startReconnect() {
         if (!this.reconnectInterval) {
             this.reconnectInterval = setInterval(() => {
@@ -272,7 +293,7 @@ class SettingsManager {
             const response = await fetch('/api/antennas');
             const antennas = await response.json();
 
-            for (let i = 0; i < 6; i++) {
+            for (let i = 0; i < antennas.length; i++) {
                 const input = document.getElementById(`antenna-${i}`);
                 if (input) {
                     input.value = antennas[i].name || '';
@@ -322,6 +343,11 @@ class SettingsManager {
             if (singleRadioModeInput) {
                 singleRadioModeInput.checked = data.singleRadioMode || false;
             }
+
+            const bandAutoSelectInput = document.getElementById('band-auto-select');
+            if (bandAutoSelectInput) {
+                bandAutoSelectInput.checked = data.bandAutoSelect || false;
+            }
         } catch (error) {
             console.error('Failed to load operation mode:', error);
             this.showMessage('Failed to load operation mode', 'error');
@@ -341,6 +367,28 @@ class SettingsManager {
         } catch (error) {
             console.error('Failed to load OTRSP settings:', error);
         }
+
+        try {
+            const response = await fetch('/api/serial');
+            const data = await response.json();
+
+            const serialBaud = document.getElementById('serial-baud');
+            const serialAutobaud = document.getElementById('serial-autobaud');
+
+            if (serialBaud) {
+                serialBaud.innerHTML = '';
+                data.rates.forEach(rate => {
+                    const option = document.createElement('option');
+                    option.value = rate;
+                    option.textContent = rate;
+                    serialBaud.appendChild(option);
+                });
+                serialBaud.value = data.baud;
+            }
+            if (serialAutobaud) serialAutobaud.checked = data.autobaud || false;
+        } catch (error) {
+            console.error('Failed to load serial settings:', error);
+        }
     }
 
     setupEventListeners() {
@@ -391,7 +439,7 @@ class SettingsManager {
     async saveSettings() {
         const antennaData = {};
 
-        for (let i = 0; i < 6; i++) {
+        for (let i = 0; document.getElementById(`antenna-${i}`); i++) {
             const input = document.getElementById(`antenna-${i}`);
             const name = input ? input.value.trim() : '';
             const bands = [];
@@ -409,10 +457,12 @@ class SettingsManager {
 
         const antennaSwappingInput = document.getElementById('antenna-swapping');
         const singleRadioModeInput = document.getElementById('single-radio-mode');
+        const bandAutoSelectInput = document.getElementById('band-auto-select');
         
         const operationMode = {
             antennaSwapping: antennaSwappingInput ? antennaSwappingInput.checked : false,
-            singleRadioMode: singleRadioModeInput ? singleRadioModeInput.checked : false
+            singleRadioMode: singleRadioModeInput ? singleRadioModeInput.checked : false,
+            bandAutoSelect: bandAutoSelectInput ? bandAutoSelectInput.checked : false
         };
 
         try {
@@ -455,7 +505,19 @@ class SettingsManager {
                 })
             });
 
-            if (antennaResponse.ok && hostnameResponse.ok && operationModeResponse.ok && otrspResponse.ok) {
+            // Save RS-485 rate
+            const serialBaudInput = document.getElementById('serial-baud');
+            const serialAutobaudInput = document.getElementById('serial-autobaud');
+            const serialResponse = await fetch('/api/serial', {
+                method: 'POST',
+                headers: { 'Content-Type': 'application/json' },
+                body: JSON.stringify({
+                    baud: serialBaudInput ? parseInt(serialBaudInput.value) : 9600,
+                    autobaud: serialAutobaudInput ? serialAutobaudInput.checked : false
+                })
+            });
+
+            if (antennaResponse.ok && hostnameResponse.ok && operationModeResponse.ok && otrspResponse.ok && serialResponse.ok) {
                 const hostnameText = await hostnameResponse.text();
                 if (hostnameText.includes('Restart required')) {
                     this.showMessage('Settings saved! Restart device to apply hostname changes.', 'success');
@@ -471,6 +533,9 @@ class SettingsManager {
                 } else if (!hostnameResponse.ok) {
                     const errorText = await hostnameResponse.text();
                     this.showMessage(`Failed to save hostname: ${errorText}`, 'error');
+                } else if (!serialResponse.ok) {
+                    const errorText = await serialResponse.text();
+                    this.showMessage(`Failed to save baud rate: ${errorText}`, 'error');
                 } else {
                     this.showMessage('Failed to save operation mode', 'error');
                 }
@@ -2,6 +2,7 @@
 #define ANTENNA_HARDWARE_H
 
 #include <Arduino.h>
+#include "relay_port.h"
 
 /**
  * @brief Initialize all hardware pins
@@ -9,17 +10,101 @@
 void initializeHardware();
 
 /**
- * @brief Blink the status LED
- * @param n Number of blinks
+ * @brief Blink the status LED without blocking
+ * @param n Number of blinks, queued after any pattern already running
  */
 void blink(uint8_t n);
 
+/**
+ * @brief Advance the status LED pattern, call from loop()
+ */
+void handleStatusLed();
+
+/*
+ * Switching functions may be called from any task. The switch itself runs
+ * on the relay task; the caller waits for it to finish.
+ */
+
 /**
  * @brief Select antenna for a specific radio
- * @param radio Radio number (0 or 1)
- * @param antenna Antenna number (0-6, 0 means disconnect)
+ * @param radio Radio index (0 to MATRIX_RADIOS-1)
+ * @param antenna Antenna number (0 to MATRIX_ANTENNAS, 0 means disconnect)
  * @return 0 on success, 1 on parameter error, 2 on antenna busy
  */
 uint8_t selectAntenna(uint8_t radio, uint8_t antenna);
 
+// One radio's part of a batch switch
+struct AntennaSelection {
+  uint8_t radio;    // Radio index (0 to MATRIX_RADIOS-1)
+  uint8_t antenna;  // Antenna number (0 means disconnect)
+};
+
+/**
+ * @brief Switch several radios as one transaction
+ *
+ * The whole resulting assignment is validated first and then applied as
+ * one break/make sequence with a single client notification. Radios not
+ * listed keep their antenna.
+ *
+ * @param selections Radio/antenna pairs, each radio at most once
+ * @param count Number of pairs
+ * @return 0 on success, 1 on parameter error, 2 if the result would put
+ *         two radios on one antenna
+ */
+uint8_t selectAntennas(const AntennaSelection* selections, uint8_t count);
+
+/**
+ * @brief Disconnect one radio without notifying clients
+ * @param radio Radio index (0 to MATRIX_RADIOS-1)
+ */
+void disconnectRadio(uint8_t radio);
+
+/**
+ * @brief Disconnect every radio but the first in one break step, without
+ *        notifying clients (entering single radio mode)
+ */
+void disconnectOtherRadios();
+
+/**
+ * @brief Open all relays (used before firmware updates)
+ */
+void disconnectAll();
+
+/**
+ * @brief CPU cycles spent driving the relay outputs in the last switch
+ */
+uint32_t getLastSwitchCycles();
+
+/**
+ * @brief Get the settle time of one relay
+ * @param radio Radio index (0 to MATRIX_RADIOS-1)
+ * @param antenna Antenna index (0 to MATRIX_ANTENNAS-1)
+ * @return Settle time in milliseconds
+ */
+uint16_t getRelaySettleMs(uint8_t radio, uint8_t antenna);
+
+/**
+ * @brief Set the settle time of one relay
+ * @param radio Radio index (0 to MATRIX_RADIOS-1)
+ * @param antenna Antenna index (0 to MATRIX_ANTENNAS-1)
+ * @param ms Time the relay needs after release before the next contact closes
+ *
+ * Applied on the relay task like a switch request, so a switch in progress
+ * never sees the table change; returns once applied.
+ */
+void setRelaySettleMs(uint8_t radio, uint8_t antenna, uint16_t ms);
+
+/**
+ * @brief Step timestamps (esp_timer microseconds) of the last switch
+ */
+SwitchTrace getSwitchTrace();
+
+/**
+ * @brief Run switch requests on the calling task, bypassing the relay task
+ *
+ * For the host benchmarks, which time the parsers without the task
+ * handoff. Only safe while a single task switches and settle times are 0.
+ */
+void setRelayInline(bool enabled);
+
 #endif
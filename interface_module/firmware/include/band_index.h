@@ -0,0 +1,70 @@
+#ifndef BAND_INDEX_H
+#define BAND_INDEX_H
+
+#include <Arduino.h>
+#include "matrix_config.h"
+
+// Amateur bands an antenna can be assigned to
+enum BandId : uint8_t {
+  BAND_160M = 0,
+  BAND_80M,
+  BAND_60M,
+  BAND_40M,
+  BAND_30M,
+  BAND_20M,
+  BAND_17M,
+  BAND_15M,
+  BAND_12M,
+  BAND_10M,
+  BAND_6M,
+  BAND_COUNT,
+  BAND_NONE = 0xFF
+};
+
+/**
+ * @brief Rebuild the band -> antenna bitmask index from antennas[].bands
+ *
+ * Call whenever antenna bands change; lookups never touch the strings.
+ */
+void rebuildBandIndex();
+
+/**
+ * @brief Antennas allowed on a band
+ * @param band Band ID
+ * @return Antenna bitmask (bit n = antenna n+1), 0 for BAND_NONE
+ */
+Matrix::AntennaMask bandAntennas(uint8_t band);
+
+/**
+ * @brief Map a band name such as "20m" to its ID
+ * @return Band ID or BAND_NONE
+ */
+uint8_t bandFromName(const char* name);
+
+/**
+ * @brief Map a band report to its ID: a band name ("20m"), a
+ *        frequency in MHz ("14.025") or a band's lower edge in whole
+ *        MHz ("3" = 80m)
+ * @return Band ID or BAND_NONE
+ */
+uint8_t bandFromReport(const char* report);
+
+/**
+ * @brief Name of a band ID, e.g. "20m"
+ */
+const char* bandName(uint8_t band);
+
+/**
+ * @brief Move a radio to the preferred free antenna for a band
+ *
+ * Keeps the current antenna if it is allowed on the band, otherwise
+ * selects the lowest-numbered allowed antenna not in use by another
+ * radio. Does nothing if no such antenna exists.
+ *
+ * @param radio Radio index (0 to MATRIX_RADIOS-1)
+ * @param band Band ID
+ * @return Antenna the radio is on afterwards, 0 if none was found
+ */
+uint8_t selectAntennaForBand(uint8_t radio, uint8_t band);
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef CHUNKED_JSON_H
+#define CHUNKED_JSON_H
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Print that keeps a window of what is printed
+ *
+ * Bytes [skip, skip + size) of the output land in the buffer; the rest
+ * is only counted.
+ */
+class WindowPrint : public Print {
+public:
+  WindowPrint(uint8_t* buffer, size_t size, size_t skip)
+    : buffer_(buffer), size_(size), skip_(skip), printed_(0) {}
+
+  size_t write(uint8_t c) override {
+    if(printed_ >= skip_ && printed_ - skip_ < size_)
+      buffer_[printed_ - skip_] = c;
+    printed_++;
+    return 1;
+  }
+
+  size_t write(const uint8_t* data, size_t length) override {
+    for(size_t i = 0; i < length; i++)
+      write(data[i]);
+    return length;
+  }
+  using Print::write;
+
+  /**
+   * @brief Bytes printed in total, inside the window or not
+   */
+  size_t printed() const { return printed_; }
+
+  /**
+   * @brief Bytes stored in the buffer
+   */
+  size_t filled() const { return printed_ <= skip_ ? 0 : min(printed_ - skip_, size_); }
+
+private:
+  uint8_t* buffer_;
+  size_t size_;
+  size_t skip_;
+  size_t printed_;
+};
+
+/**
+ * @brief Response body printed piece by piece into chunk buffers
+ *
+ * The renderer prints piece `index` (a few fields, one antenna) and
+ * returns false past the last one. Each piece is rendered straight into
+ * the chunk buffer, so no body is ever held in memory and a response
+ * costs about the same heap for any number of antennas and bands.
+ *
+ * A piece is only rendered within one fill(): if it does not fit the
+ * room left, it is rendered a second time in the same call to keep the
+ * rest for the next chunk. The data it prints may change between chunks
+ * (a POST handled between two of them), but never in the middle of a
+ * piece, so the body is always valid JSON.
+ */
+class ChunkedJson {
+public:
+  typedef std::function<bool(uint16_t index, Print& out)> Renderer;
+
+  explicit ChunkedJson(Renderer render) : render_(render), index_(0), restSent_(0) {}
+
+  /**
+   * @brief Fill a chunk buffer with the next part of the body
+   * @return Bytes written, 0 once the body is complete
+   */
+  size_t fill(uint8_t* buffer, size_t size) {
+    size_t filled = 0;
+
+    // Rest of a piece that did not fit the last buffer
+    if(restSent_ < rest_.size()) {
+      filled = min(rest_.size() - restSent_, size);
+      memcpy(buffer, rest_.data() + restSent_, filled);
+      restSent_ += filled;
+      if(restSent_ < rest_.size())
+        return filled;
+      std::vector<uint8_t>().swap(rest_);
+      restSent_ = 0;
+    }
+
+    while(filled < size) {
+      WindowPrint window(buffer + filled, size - filled, 0);
+      if(!render_(index_, window))
+        break;
+      filled += window.filled();
+
+      if(window.printed() > window.filled()) {
+        // Buffer full in the middle of the piece: keep the rest now,
+        // before anything it prints can change
+        rest_.resize(window.printed() - window.filled());
+        WindowPrint restWindow(rest_.data(), rest_.size(), window.filled());
+        render_(index_, restWindow);
+      }
+      index_++;
+    }
+    return filled;
+  }
+
+private:
+  Renderer render_;
+  uint16_t index_;
+  std::vector<uint8_t> rest_;
+  size_t restSent_;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef COMMAND_RING_H
+#define COMMAND_RING_H
+
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * @brief Bounded lock-free multi-producer, single-consumer ring
+ *
+ * Each slot carries a sequence number telling whether it is free for
+ * the producer of a given lap or filled for the consumer, so producers
+ * only contend on one compare-and-swap of the write index and never
+ * wait for each other. push() and pop() are safe from any task; pop()
+ * must only ever be called from one.
+ */
+template<typename T, uint8_t Size>
+class CommandRing {
+  static_assert(Size >= 2 && (Size & (Size - 1)) == 0, "ring size must be a power of two");
+
+public:
+  CommandRing() : head_(0), tail_(0) {
+    for(uint8_t i = 0; i < Size; i++)
+      slots_[i].seq.store(i, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Append an item
+   * @return false if the ring is full
+   */
+  bool push(const T& item) {
+    uint32_t pos = head_.load(std::memory_order_relaxed);
+    Slot* slot;
+    for(;;) {
+      slot = &slots_[pos & (Size - 1)];
+      int32_t diff = (int32_t)(slot->seq.load(std::memory_order_acquire) - pos);
+      if(diff == 0) {
+        if(head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          break;
+      } else if(diff < 0) {
+        return false;
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+    slot->item = item;
+    slot->seq.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Take the oldest item, consumer task only
+   * @return false if the ring is empty
+   */
+  bool pop(T& item) {
+    Slot& slot = slots_[tail_ & (Size - 1)];
+    if((int32_t)(slot.seq.load(std::memory_order_acquire) - (tail_ + 1)) < 0)
+      return false;
+    item = slot.item;
+    slot.seq.store(tail_ + Size, std::memory_order_release);
+    tail_++;
+    return true;
+  }
+
+private:
+  struct Slot {
+    std::atomic<uint32_t> seq;
+    T item;
+  };
+
+  Slot slots_[Size];
+  std::atomic<uint32_t> head_;
+  uint32_t tail_;
+};
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include <vector>
+#include "matrix_config.h"
 
 // Hardware pin definitions
 #define STATUS_LED  33
@@ -10,9 +11,27 @@
 #define TXD2        17
 #define BUF_SIZE    32
 
+static_assert(relayPinCount(relayPins, STATUS_LED) == 0 &&
+              relayPinCount(relayPins, RXD2) == 0 &&
+              relayPinCount(relayPins, TXD2) == 0,
+              "MATRIX_RELAY_PINS uses the status LED or UART2 GPIO");
+
+// Device identification, e.g. "6x2 Antenna Switch SQ9NJE"
+#define MATRIX_STR_(x)  #x
+#define MATRIX_STR(x)   MATRIX_STR_(x)
+#define DEVICE_NAME     MATRIX_STR(MATRIX_ANTENNAS) "x" MATRIX_STR(MATRIX_RADIOS) " Antenna Switch SQ9NJE"
+
+// Status LED blink half-period
+#define BLINK_PHASE_MS  50
+
+// Relay control task: above loop() and AsyncTCP so web traffic cannot
+// delay a switch, on the Arduino core away from the WiFi stack
+#define RELAY_TASK_CORE      1
+#define RELAY_TASK_PRIORITY  5
+#define RELAY_TASK_STACK     3072
+
 // Forward declarations
 class AsyncWebServer;
-class WebSocketsServer;
 
 // Antenna configuration
 struct AntennaConfig {
@@ -21,17 +40,18 @@ struct AntennaConfig {
 };
 
 // Global variables
-extern uint8_t currentAntenna[2];
-extern const uint8_t relay[2][6];
-extern AntennaConfig antennas[6];
+extern uint8_t currentAntenna[MATRIX_RADIOS];
+extern AntennaConfig antennas[MATRIX_ANTENNAS];
 extern String mdnsHostname;
 extern bool antennaSwappingEnabled;
 extern bool singleRadioMode;
 extern bool otrspEnabled;
 extern bool otrspSerialEnabled;
+extern bool bandAutoSelect;
+extern uint32_t serialBaud;      // UART2 rate
+extern bool serialAutobaud;      // detect the UART2 rate at boot
 
 // Global objects
 extern AsyncWebServer server;
-extern WebSocketsServer webSocket;
 
 #endif
@@ -0,0 +1,24 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include "relay_port.h"
+
+/*
+ * Platform layer under the control logic. Everything else reaches the
+ * chip through Arduino calls (millis, Stream, pinMode) and SPIFFS, which
+ * the native build provides on the host; the relay outputs and settle
+ * timer come from here. ESP32: hal_esp32.cpp, host: native/hal_native.cpp.
+ */
+
+/**
+ * @brief Relay output port of this platform
+ */
+RelayPort& halRelayPort();
+
+/**
+ * @brief Start the relay port's settle timer
+ * @param onTimer Called from the timer context whenever a schedule() expires
+ */
+void halRelayPortBegin(void (*onTimer)());
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <Arduino.h>
+
+// Where a switch command entered the device
+enum LatencySource : uint8_t {
+  LATENCY_USB = 0,     // UART0 native commands
+  LATENCY_UART2,       // UART2 native or OTRSP commands
+  LATENCY_OTRSP_TCP,   // OTRSP over TCP
+  LATENCY_WEBSOCKET,   // WebSocket select messages
+  LATENCY_REST,        // REST handlers that change relays
+  LATENCY_SOURCES
+};
+
+struct LatencySummary {
+  uint32_t count;
+  uint32_t p50Us;
+  uint32_t p99Us;
+  uint32_t maxUs;
+};
+
+/**
+ * @brief Mark the start of a command about to be executed
+ * @param source Ingress source
+ * @param startUs micros() when its first byte arrived
+ *
+ * Each task has its own open command, so loop() and AsyncTCP can be
+ * measured at the same time; a second begin on a task replaces its first.
+ */
+void latencyBegin(LatencySource source, uint32_t startUs);
+
+/**
+ * @brief Finish the command started with latencyBegin()
+ */
+void latencyEnd();
+
+/**
+ * @brief Record ingress-to-GPIO latency, call at the relay GPIO write
+ * @param requester Task that called latencyBegin() for this switch
+ *
+ * Only the first write after latencyBegin() on that task counts.
+ */
+void latencyMarkSwitch(TaskHandle_t requester);
+
+/**
+ * @brief Summarize one source's histogram
+ * @param source Ingress source
+ * @return Sample count, p50/p99 (bucket upper bounds) and exact max
+ */
+LatencySummary latencySummary(LatencySource source);
+
+/**
+ * @brief Short name of a source for reports
+ */
+const char* latencySourceName(LatencySource source);
+
+/**
+ * @brief Clear all histograms
+ */
+void latencyReset();
+
+#endif
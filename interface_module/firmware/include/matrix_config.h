@@ -0,0 +1,30 @@
+#ifndef MATRIX_CONFIG_H
+#define MATRIX_CONFIG_H
+
+#include "matrix_switch.h"
+
+// Matrix size and relay wiring. Other layouts are built by overriding
+// all three with build flags, e.g.
+//   -DMATRIX_RADIOS=2 -DMATRIX_ANTENNAS=7
+//   '-DMATRIX_RELAY_PINS={{13,12,14,27,26,25,32},{5,18,19,21,22,23,4}}'
+#ifndef MATRIX_RADIOS
+#define MATRIX_RADIOS   2
+#endif
+#ifndef MATRIX_ANTENNAS
+#define MATRIX_ANTENNAS 6
+#endif
+
+#ifndef MATRIX_RELAY_PINS
+#if MATRIX_RADIOS != 2 || MATRIX_ANTENNAS != 6
+#error "Non-default matrix size needs MATRIX_RELAY_PINS"
+#endif
+#define MATRIX_RELAY_PINS {{13, 12, 14, 27, 26, 25}, {5, 18, 19, 21, 22, 23}}
+#endif
+
+// Relay GPIO per [radio][antenna-1]
+constexpr uint8_t relayPins[MATRIX_RADIOS][MATRIX_ANTENNAS] = MATRIX_RELAY_PINS;
+static_assert(relayPinsValid(relayPins), "MATRIX_RELAY_PINS has a duplicate or non-output GPIO");
+
+typedef MatrixSwitch<MATRIX_RADIOS, MATRIX_ANTENNAS> Matrix;
+
+#endif
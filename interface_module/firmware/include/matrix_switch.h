@@ -0,0 +1,256 @@
+#ifndef MATRIX_SWITCH_H
+#define MATRIX_SWITCH_H
+
+#include <stdint.h>
+#include "relay_port.h"
+
+// Default time a relay needs after being released before the next
+// contact may close
+#define RELAY_DEFAULT_SETTLE_MS 5
+
+/**
+ * @brief GPIO usable as a relay output (ESP32: not the GPIO0 strapping
+ *        pin, not flash, not input-only). Pins the board uses for
+ *        other things are checked in globals.h.
+ */
+constexpr bool relayPinValid(uint8_t pin) {
+  return pin > 0 && pin < 34 && (pin < 6 || pin > 11);
+}
+
+template<uint8_t Radios, uint8_t Antennas>
+constexpr uint8_t relayPinAt(const uint8_t (&pins)[Radios][Antennas], uint16_t i) {
+  return pins[i / Antennas][i % Antennas];
+}
+
+template<uint8_t Radios, uint8_t Antennas>
+constexpr uint16_t relayPinCount(const uint8_t (&pins)[Radios][Antennas], uint8_t pin, uint16_t i = 0) {
+  return i == Radios * Antennas ? 0 :
+    (relayPinAt(pins, i) == pin) + relayPinCount(pins, pin, i + 1);
+}
+
+/**
+ * @brief Check a whole relay pin table at compile time: every pin can
+ *        drive a relay and is used once. Short rows are zero-filled and
+ *        so fail as GPIO0.
+ */
+template<uint8_t Radios, uint8_t Antennas>
+constexpr bool relayPinsValid(const uint8_t (&pins)[Radios][Antennas], uint16_t i = 0) {
+  return i == Radios * Antennas ||
+    (relayPinValid(relayPinAt(pins, i)) &&
+     relayPinCount(pins, relayPinAt(pins, i)) == 1 &&
+     relayPinsValid(pins, i + 1));
+}
+
+/**
+ * @brief Break-before-make relay sequencer for a Radios x Antennas matrix
+ *
+ * Relay state is kept as one antenna bitmask per radio. A transition
+ * to a new target opens every relay leaving the target in one port
+ * write (break), waits for the longest settle time of the opened
+ * relays, then closes every relay entering the target in one port
+ * write (make). The wait runs on the port timer, apply() never blocks.
+ *
+ * All loops run over the compile-time dimensions; callers validate
+ * indices once at ingress with valid().
+ */
+template<uint8_t Radios, uint8_t Antennas>
+class MatrixSwitch {
+  static_assert(Radios >= 1 && Radios <= 32, "radio bitmasks are 32 bits");
+  static_assert(Antennas >= 1 && Antennas <= 32, "antenna bitmask is 32 bits");
+
+public:
+  typedef uint32_t AntennaMask;
+
+  static constexpr uint8_t radios = Radios;
+  static constexpr uint8_t antennas = Antennas;
+
+  /**
+   * @brief Check a radio index (0-based) and antenna number (0 = none)
+   */
+  static constexpr bool valid(uint8_t radio, uint8_t antenna) {
+    return radio < Radios && antenna <= Antennas;
+  }
+
+  /**
+   * @brief Create a switch for a relay pin table
+   * @param port Output port
+   * @param pins GPIO number of each relay, indexed [radio][antenna-1]
+   */
+  MatrixSwitch(RelayPort& port, const uint8_t (&pins)[Radios][Antennas])
+    : port_(port), output_(0), settledAt_(0), makePending_(false), trace_() {
+    for(uint8_t radio = 0; radio < Radios; radio++) {
+      state_[radio] = 0;
+      for(uint8_t antenna = 0; antenna < Antennas; antenna++) {
+        pinBit_[radio][antenna] = 1ULL << pins[radio][antenna];
+        settleMs_[radio][antenna] = RELAY_DEFAULT_SETTLE_MS;
+      }
+    }
+  }
+
+  /**
+   * @brief Open all relays, drop any pending make and reset the state
+   */
+  void reset() {
+    uint64_t all = 0;
+    port_.lock();
+    for(uint8_t radio = 0; radio < Radios; radio++) {
+      all |= pinMask(radio, ~(AntennaMask)0);
+      state_[radio] = 0;
+    }
+    port_.write(0, all);
+    output_ = 0;
+    makePending_ = false;
+    port_.unlock();
+  }
+
+  /**
+   * @brief Switch all radios to a new antenna assignment
+   * @param target Antenna per radio (0 means disconnected)
+   */
+  void apply(const uint8_t (&target)[Radios]) {
+    uint32_t waitUs = 0;
+
+    port_.lock();
+    uint64_t now = port_.nowUs();
+    trace_.requestUs = now;
+    trace_.breakUs = 0;
+    trace_.makeUs = 0;
+
+    // Break: open every relay that is closed but not part of the target
+    uint64_t breakMask = 0;
+    uint32_t settleUs = 0;
+    for(uint8_t radio = 0; radio < Radios; radio++) {
+      state_[radio] = target[radio] > 0 ? ((AntennaMask)1 << (target[radio] - 1)) : 0;
+      for(uint8_t antenna = 0; antenna < Antennas; antenna++) {
+        uint64_t bit = pinBit_[radio][antenna];
+        if((output_ & bit) && !(state_[radio] & ((AntennaMask)1 << antenna))) {
+          breakMask |= bit;
+          if(settleMs_[radio][antenna] * 1000UL > settleUs)
+            settleUs = settleMs_[radio][antenna] * 1000UL;
+        }
+      }
+    }
+    if(breakMask) {
+      port_.write(0, breakMask);
+      output_ &= ~breakMask;
+      trace_.breakUs = port_.nowUs();
+      if(trace_.breakUs + settleUs > settledAt_)
+        settledAt_ = trace_.breakUs + settleUs;
+    }
+
+    // Make: close the new relays now or once the opened ones have settled
+    bool scheduled = false;
+    if(!makeIfSettled(port_.nowUs(), &waitUs)) {
+      makePending_ = true;
+      scheduled = true;
+    }
+    port_.unlock();
+
+    if(scheduled)
+      port_.schedule(waitUs);
+  }
+
+  /**
+   * @brief Timer callback, completes a pending make step
+   */
+  void onTimer() {
+    uint32_t waitUs = 0;
+    bool reschedule = false;
+
+    port_.lock();
+    if(makePending_ && !makeIfSettled(port_.nowUs(), &waitUs))
+      reschedule = true;
+    port_.unlock();
+
+    // A later apply() may have pushed the settle deadline out
+    if(reschedule)
+      port_.schedule(waitUs);
+  }
+
+  /**
+   * @brief Set how long a relay needs to settle after being released
+   * @param radio Radio index (0-based)
+   * @param antenna Antenna index (0-based)
+   * @param ms Settle time in milliseconds
+   */
+  void setSettleMs(uint8_t radio, uint8_t antenna, uint16_t ms) {
+    if(radio < Radios && antenna < Antennas)
+      settleMs_[radio][antenna] = ms;
+  }
+  uint16_t settleMs(uint8_t radio, uint8_t antenna) const {
+    return radio < Radios && antenna < Antennas ? settleMs_[radio][antenna] : 0;
+  }
+
+  /**
+   * @brief Target antenna bitmask of a radio (bit n = antenna n+1)
+   */
+  AntennaMask state(uint8_t radio) const { return state_[radio]; }
+
+  /**
+   * @brief Pins currently driven high
+   */
+  uint64_t outputMask() const { return output_; }
+
+  /**
+   * @brief True while a make step is waiting for relays to settle
+   */
+  bool busy() const { return makePending_; }
+
+  /**
+   * @brief Step timestamps of the last switch
+   */
+  SwitchTrace lastTrace() const { return trace_; }
+
+private:
+  uint64_t pinMask(uint8_t radio, AntennaMask bits) const {
+    uint64_t mask = 0;
+    for(uint8_t antenna = 0; antenna < Antennas; antenna++) {
+      if(bits & ((AntennaMask)1 << antenna))
+        mask |= pinBit_[radio][antenna];
+    }
+    return mask;
+  }
+
+  uint64_t targetMask() const {
+    uint64_t mask = 0;
+    for(uint8_t radio = 0; radio < Radios; radio++) {
+      mask |= pinMask(radio, state_[radio]);
+    }
+    return mask;
+  }
+
+  // Close every target relay not yet closed once all released relays
+  // have settled. Returns false and the remaining wait otherwise.
+  bool makeIfSettled(uint64_t now, uint32_t* waitUs) {
+    if(now < settledAt_) {
+      *waitUs = (uint32_t)(settledAt_ - now);
+      return false;
+    }
+
+    uint64_t makeMask = targetMask() & ~output_;
+    if(makeMask) {
+      port_.write(makeMask, 0);
+      output_ |= makeMask;
+      trace_.makeUs = port_.nowUs();
+    }
+    makePending_ = false;
+    return true;
+  }
+
+  RelayPort& port_;
+  uint64_t pinBit_[Radios][Antennas];
+  uint16_t settleMs_[Radios][Antennas];
+  AntennaMask state_[Radios];
+  uint64_t output_;
+  uint64_t settledAt_;
+  bool makePending_;
+  SwitchTrace trace_;
+};
+
+template<uint8_t Radios, uint8_t Antennas>
+constexpr uint8_t MatrixSwitch<Radios, Antennas>::radios;
+
+template<uint8_t Radios, uint8_t Antennas>
+constexpr uint8_t MatrixSwitch<Radios, Antennas>::antennas;
+
+#endif
@@ -2,25 +2,47 @@
 #define OTRSP_H
 
 #include <Arduino.h>
-#include <WiFiServer.h>
-#include <WiFiClient.h>
 
 #define OTRSP_TCP_PORT 12060
 #define OTRSP_BUF_SIZE 40
+#define OTRSP_MAX_CLIENTS 4
+#define OTRSP_REPLY_SIZE 128
 
+#define OTRSP_RX_SIZE   4
+#define OTRSP_BAND_SIZE 12
+
+// Fixed-size fields, so the OTRSP stream never touches the heap
 struct OTRSPState {
-    uint8_t txFocus;       // 1 or 2
-    String rxFocus;        // "1", "2", "1S", "2S", "1R", "2R"
-    String band[2];        // frequency string per radio
-    char mode[2];          // mode char per radio (C/U/L/R/F/A/X/0)
-    bool clientConnected;
+    uint8_t txFocus;                 // 1 or 2
+    char rxFocus[OTRSP_RX_SIZE];     // "1", "2", "1S", "2S", "1R", "2R"
+    char band[2][OTRSP_BAND_SIZE];   // frequency string per radio
+    char mode[2];                    // mode char per radio (C/U/L/R/F/A/X/0)
+    uint8_t clients;                 // connected TCP clients
+};
+
+// Connected TCP client, for status reports
+struct OTRSPClientInfo {
+    uint32_t ip;
+    uint16_t port;
+    uint32_t connectedMs;
+    uint32_t lines;       // commands parsed
+    uint32_t serviceUs;   // time spent parsing and answering its packets
 };
 
 extern OTRSPState otrspState;
 
-void initializeOTRSP();
-void handleOTRSPLoop();
+// Protocol (otrsp.cpp)
 void parseOTRSPCommand(const char* cmd, Stream& response);
 void handleOTRSPSerialInput(Stream& serial);
+void otrspPushChanges();                  // send changed AUX/TX/RX lines to subscribers
+void otrspUnsubscribe(Stream& stream);    // drop a closed connection's subscription
+
+// TCP server (AsyncTCP callbacks) and UART2 polling (otrsp_server.cpp)
+void initializeOTRSP();
+void handleOTRSPLoop();
+void otrspPushNow();                      // push switches made outside OTRSP (web UI, REST) right away
+bool otrspClientInfo(uint8_t slot, OTRSPClientInfo* info);
+uint32_t otrspPacketUs();                 // mean time to handle one received TCP packet
+size_t otrspClientBytes();                // RAM per client slot
 
 #endif
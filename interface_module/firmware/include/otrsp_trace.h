@@ -0,0 +1,71 @@
+#ifndef OTRSP_TRACE_H
+#define OTRSP_TRACE_H
+
+#include <Arduino.h>
+
+// Capture ring, allocated on first start; holds about 700 typical lines
+#define OTRSP_TRACE_BYTES 8192
+
+// Line sources: UART2, or TCP client slot 1..OTRSP_MAX_CLIENTS
+#define OTRSP_TRACE_UART2 0
+
+struct OTRSPTraceStatus {
+    bool active;
+    uint32_t records;       // lines held
+    uint32_t overwritten;   // oldest lines dropped to make room
+    uint32_t bytes;         // ring capacity
+};
+
+/**
+ * @brief Clear the ring and start capturing received OTRSP lines
+ * @return false if the ring could not be allocated
+ */
+bool otrspTraceStart();
+
+/**
+ * @brief Stop capturing, keeping the recorded lines for download
+ */
+void otrspTraceStop();
+
+/**
+ * @brief Record one received line, before it is parsed
+ * @param source OTRSP_TRACE_UART2 or TCP client slot (1-based)
+ * @param line Line without its terminator
+ *
+ * Returns at once while capture is off. Safe from any task.
+ */
+void otrspTraceRecord(uint8_t source, const char* line);
+
+OTRSPTraceStatus otrspTraceStatus();
+
+// Longest line of a trace file, the header included
+#define OTRSP_TRACE_LINE_SIZE 96
+
+// Read position of a trace download
+struct OTRSPTraceCursor {
+    uint32_t seq;         // next record
+    uint32_t offset;      // its offset in the ring
+    uint32_t prevUs;      // micros() of the last record read
+    uint64_t elapsedUs;   // since the first record
+    bool header;          // header line given out
+    bool started;         // first record read
+};
+
+/**
+ * @brief Set a cursor to the start of the trace file
+ */
+void otrspTraceRewind(OTRSPTraceCursor& cursor);
+
+/**
+ * @brief Format the next line of the trace file, oldest record first
+ * @param text Buffer of at least OTRSP_TRACE_LINE_SIZE bytes
+ * @return Line length including its '\n', 0 once every record is read
+ *
+ * The first line is a '#' comment header, then one line per record:
+ * microseconds since the first record, source (U2, T1..T4) and the
+ * OTRSP line. Capture may go on meanwhile; records overwritten before
+ * the cursor reaches them are skipped.
+ */
+size_t otrspTraceNextLine(OTRSPTraceCursor& cursor, char* text, size_t size);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef RELAY_PORT_H
+#define RELAY_PORT_H
+
+#include <stdint.h>
+
+/**
+ * @brief Output port and timer the matrix switch drives
+ *
+ * Implementations apply a whole set/clear mask in one operation, so
+ * every relay in a mask changes state at the same instant. Bit n of a
+ * mask is GPIO n.
+ */
+class RelayPort {
+public:
+  virtual ~RelayPort() {}
+
+  /**
+   * @brief Drive the pins in setMask high and the pins in clearMask low
+   * @param setMask Pins to set
+   * @param clearMask Pins to clear
+   */
+  virtual void write(uint64_t setMask, uint64_t clearMask) = 0;
+
+  /**
+   * @brief Monotonic time in microseconds
+   */
+  virtual uint64_t nowUs() = 0;
+
+  /**
+   * @brief Call the switch's onTimer() once after delayUs, replacing any
+   *        callback still pending
+   * @param delayUs Delay in microseconds
+   */
+  virtual void schedule(uint32_t delayUs) = 0;
+
+  /**
+   * @brief Guard switch state against the timer callback
+   */
+  virtual void lock() {}
+  virtual void unlock() {}
+};
+
+/**
+ * @brief Timestamps of the steps of the last switch
+ */
+struct SwitchTrace {
+  uint64_t requestUs;  // apply() called
+  uint64_t breakUs;    // released relays opened (0 = nothing to open)
+  uint64_t makeUs;     // new relays closed (0 = nothing to close yet)
+};
+
+#endif
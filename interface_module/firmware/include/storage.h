@@ -16,8 +16,22 @@ void loadSettings();
 
 /**
  * @brief Save settings to storage
+ * @return false if the settings did not fit the JSON document or the file
+ *         could not be written; the previous file is then kept
  */
-void saveSettings();
+bool saveSettings();
+
+/**
+ * @brief JsonDocument capacity for the antennas array (names and bands) as
+ *        currently configured
+ */
+size_t antennasJsonCapacity();
+
+/**
+ * @brief JsonDocument capacity to parse settings or antenna JSON text
+ * @param length Length of the JSON text in bytes
+ */
+size_t settingsJsonCapacity(size_t length);
 
 /**
  * @brief Validate and sanitize hostname
@@ -0,0 +1,39 @@
+#ifndef UART2_H
+#define UART2_H
+
+#include <Arduino.h>
+
+#define UART2_DEFAULT_BAUD         9600
+#define UART2_AUTOBAUD_TIMEOUT_MS  3000
+#define UART2_RX_BUFFER            512   // about 5 ms of input at 921600
+
+// Rates offered in the web UI and accepted from settings and REST
+static const uint32_t UART2_RATES[] = {
+  9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600
+};
+#define UART2_RATE_COUNT (sizeof(UART2_RATES) / sizeof(UART2_RATES[0]))
+
+inline bool uart2BaudValid(uint32_t baud) {
+  for(size_t i = 0; i < UART2_RATE_COUNT; i++) {
+    if(UART2_RATES[i] == baud)
+      return true;
+  }
+  return false;
+}
+
+/**
+ * @brief Open UART2 at serialBaud, after loadSettings()
+ *
+ * With serialAutobaud set, first waits up to UART2_AUTOBAUD_TIMEOUT_MS
+ * for traffic to measure the rate; a detected supported rate replaces
+ * serialBaud and is saved.
+ */
+void initializeUART2();
+
+/**
+ * @brief Change the UART2 rate at runtime
+ * @return false if the rate is not one of UART2_RATES
+ */
+bool uart2SetBaud(uint32_t baud);
+
+#endif
@@ -1,21 +1,34 @@
 #ifndef WEBSOCKET_H
 #define WEBSOCKET_H
 
-#include <WebSocketsServer.h>
-#include <ArduinoJson.h>
+#include <Arduino.h>
+
+// Served by the port 80 web server; the binary protocol is on WSB_PATH
+#define WS_PATH "/ws"
+
+// Shortest interval between two broadcasts of the same frame
+#define WS_BROADCAST_TICK_MS 50
 
 /**
- * @brief Send WebSocket update with current antenna state
+ * @brief Mark the antenna state for broadcast
+ *
+ * Safe from any task; handleWebSocketBroadcasts() takes the antennas and
+ * modes current at that time, counts a new state version if any of them
+ * changed and only then sends the frame.
  */
 void sendWebSocketUpdate();
 
 /**
- * @brief Send antenna names update via WebSocket
+ * @brief Re-serialize the antenna names and mark them for broadcast
+ *
+ * Call after antenna names or bands change, from the task that changed
+ * them and after initializeWebSocket(); the frame is rendered there and
+ * cached for connecting clients.
  */
 void sendAntennaNameUpdate();
 
 /**
- * @brief Send OTA status update via WebSocket
+ * @brief Queue an OTA status update, replacing one not yet sent
  * @param status Status string (starting, progress, complete, error)
  * @param message Additional message
  * @param progress Progress percentage (0-100)
@@ -23,16 +36,16 @@ void sendAntennaNameUpdate();
 void sendOTAStatus(const String& status, const String& message, uint8_t progress);
 
 /**
- * @brief Handle WebSocket events
- * @param num Client number
- * @param type Event type
- * @param payload Event payload
- * @param length Payload length
+ * @brief Broadcast the frames marked since the last call, from loop()
+ * @param now Send even if the last broadcast was less than a tick ago
+ *
+ * Sends at most one state, names and OTA frame per WS_BROADCAST_TICK_MS,
+ * each with the latest data, however many changes were marked.
  */
-void webSocketEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t length);
+void handleWebSocketBroadcasts(bool now = false);
 
 /**
- * @brief Initialize WebSocket server
+ * @brief Attach the WebSocket handlers to the web server, before server.begin()
  */
 void initializeWebSocket();
 
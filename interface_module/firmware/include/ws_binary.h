@@ -0,0 +1,39 @@
+#ifndef WS_BINARY_H
+#define WS_BINARY_H
+
+#include <stdint.h>
+#include "matrix_config.h"
+
+/*
+ * Binary WebSocket subprotocol for panels and scripts, chosen by the
+ * connection path (ws://<host>/ws/bin). Frames are binary messages with
+ * a one-byte type; multi-byte fields are little-endian. Antenna names
+ * and OTA status stay JSON text frames.
+ *
+ *   STATE  server  [type][seq lo][seq hi][flags][antenna per radio]
+ *   SELECT client  [type][tag][count][radio][antenna]...  (radio 0-based)
+ *   ACK    server  [type][tag][result]
+ */
+
+#define WSB_PATH "/ws/bin"
+
+enum WsbType : uint8_t {
+  WSB_STATE  = 0x01,
+  WSB_SELECT = 0x10,
+  WSB_ACK    = 0x11
+};
+
+// STATE flags
+#define WSB_FLAG_SINGLE_RADIO  0x01
+
+// ACK result: selectAntenna()/selectAntennas() codes, or a bad frame
+#define WSB_RESULT_OK         0
+#define WSB_RESULT_PARAM      1
+#define WSB_RESULT_BUSY       2
+#define WSB_RESULT_MALFORMED  3
+
+#define WSB_STATE_SIZE   (4 + MATRIX_RADIOS)
+#define WSB_SELECT_HEADER 3
+#define WSB_ACK_SIZE     3
+
+#endif
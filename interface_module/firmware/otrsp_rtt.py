@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+
+"""
+Measure OTRSP round-trip time over TCP for a burst of queries.
+
+Each round sends a burst of query commands in a single write and times
+until every reply has arrived, the way a logger polls the switch after
+a band or focus change.
+
+Usage:
+    python otrsp_rtt.py <host> [--port 12060] [--rounds 200] [--out FILE.json]
+    python otrsp_rtt.py <host> --out before.json
+    # ... flash the new firmware ...
+    python otrsp_rtt.py <host> --out after.json
+"""
+
+import argparse
+import json
+import socket
+import time
+
+BURST = [b"?AUX1", b"?AUX2", b"?TX", b"?RX", b"?BAND1",
+         b"?BAND2", b"?MODE1", b"?MODE2", b"?NAME", b"?FW"]
+
+
+def percentile(values, p):
+    ordered = sorted(values)
+    index = min(len(ordered) - 1, int(round(p / 100 * (len(ordered) - 1))))
+    return ordered[index]
+
+
+def round_trip(sock, request, replies):
+    start = time.perf_counter()
+    sock.sendall(request)
+    received = b""
+    while received.count(b"\r") < replies:
+        data = sock.recv(1024)
+        if not data:
+            raise ConnectionError("switch closed the connection")
+        received += data
+    return (time.perf_counter() - start) * 1000
+
+
+def main():
+    parser = argparse.ArgumentParser(description="OTRSP burst round-trip time")
+    parser.add_argument("host")
+    parser.add_argument("--port", type=int, default=12060)
+    parser.add_argument("--rounds", type=int, default=200)
+    parser.add_argument("--out", help="write results as JSON")
+    args = parser.parse_args()
+
+    request = b"".join(cmd + b"\r" for cmd in BURST)
+    samples = []
+    with socket.create_connection((args.host, args.port), timeout=5) as sock:
+        sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        round_trip(sock, request, len(BURST))  # warm up
+        for _ in range(args.rounds):
+            samples.append(round_trip(sock, request, len(BURST)))
+
+    result = {
+        "host": args.host,
+        "queries": len(BURST),
+        "rounds": args.rounds,
+        "min_ms": min(samples),
+        "p50_ms": percentile(samples, 50),
+        "p99_ms": percentile(samples, 99),
+        "max_ms": max(samples),
+    }
+    print(f"{len(BURST)} queries x {args.rounds} rounds: "
+          f"min {result['min_ms']:.2f} ms, p50 {result['p50_ms']:.2f} ms, "
+          f"p99 {result['p99_ms']:.2f} ms, max {result['max_ms']:.2f} ms")
+
+    if args.out:
+        with open(args.out, "w") as f:
+            json.dump(result, f, indent=2)
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
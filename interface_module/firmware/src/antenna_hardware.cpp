@@ -1,15 +1,227 @@
 #include "antenna_hardware.h"
 #include "globals.h"
 #include "websocket.h"
+#include "latency_stats.h"
+#include "command_ring.h"
+#include "hal.h"
+
+// Relay task notification bits
+#define RELAY_EVENT_COMMAND  (1UL << 0)
+#define RELAY_EVENT_TIMER    (1UL << 1)
+
+#define RELAY_RING_SIZE      8
+
+enum RelayOp : uint8_t {
+  RELAY_SELECT,          // One radio, with swap and single radio rules
+  RELAY_BATCH,           // Several radios as one switch
+  RELAY_DISCONNECT,      // One radio to no antenna
+  RELAY_SINGLE_RADIO,    // Every radio but the first to no antenna
+  RELAY_DISCONNECT_ALL,  // Open every relay
+  RELAY_SETTLE           // Change one settle time, no switching
+};
+
+// A switch request, lives on the submitting task's stack until done
+struct RelayRequest {
+  RelayOp op;
+  uint8_t count;
+  AntennaSelection selections[MATRIX_RADIOS];
+  uint16_t settleMs;
+  TaskHandle_t waiter;
+  volatile bool done;
+  uint8_t result;
+};
+
+static Matrix matrix(halRelayPort(), relayPins);
+static uint32_t lastSwitchCycles = 0;
+
+// Every relay change and every write of currentAntenna happens on this
+// task, and so does every change of the settle table; other tasks hand
+// it requests through the ring. relaySlots counts the free ring slots.
+static TaskHandle_t relayTask = nullptr;
+static CommandRing<RelayRequest*, RELAY_RING_SIZE> relayRing;
+static SemaphoreHandle_t relaySlots = nullptr;
+static bool relayInline = false;
+
+static void relayTimerCallback() {
+  xTaskNotify(relayTask, RELAY_EVENT_TIMER, eSetBits);
+}
+
+// Status LED pattern: remaining on/off half-periods of BLINK_PHASE_MS each.
+// blink() runs on any task (loop, AsyncTCP, relay callers), so both are
+// only touched under blinkMux.
+static uint16_t blinkPhases = 0;
+static uint32_t blinkPhaseStart = 0;
+static portMUX_TYPE blinkMux = portMUX_INITIALIZER_UNLOCKED;
+
+static void applyAntennas(const uint8_t (&target)[MATRIX_RADIOS], TaskHandle_t requester) {
+  uint32_t start = ESP.getCycleCount();
+  matrix.apply(target);
+  latencyMarkSwitch(requester);
+  lastSwitchCycles = ESP.getCycleCount() - start;
+
+  memcpy(currentAntenna, target, sizeof(currentAntenna));
+}
+
+// Relay task side of selectAntenna()
+static uint8_t runSelect(uint8_t radio, uint8_t antenna, TaskHandle_t requester) {
+  if(!Matrix::valid(radio, antenna))
+    return 1;
+
+  uint8_t target[MATRIX_RADIOS];
+  memcpy(target, currentAntenna, sizeof(target));
+
+  // Check if antenna is already selected by another radio (unless disconnecting)
+  uint8_t otherRadio = MATRIX_RADIOS;
+  if(antenna > 0) {
+    for(uint8_t r = 0; r < MATRIX_RADIOS; r++) {
+      if(r != radio && currentAntenna[r] == antenna)
+        otherRadio = r;
+    }
+  }
+  
+  // Single radio mode - always disconnect every radio but the first
+  if(singleRadioMode && radio > 0) {
+    target[radio] = 0;
+  }
+  else if(otherRadio < MATRIX_RADIOS) {
+    // Antenna swapping disabled - return busy error
+    if(!antennaSwappingEnabled)
+      return 2;
+
+    // Swap: the other radio takes the antenna the first radio was using
+    target[radio] = antenna;
+    target[otherRadio] = singleRadioMode ? 0 : currentAntenna[radio];
+  }
+  else {
+    target[radio] = antenna;
+  }
+
+  // Break now, make once the released relays have settled
+  applyAntennas(target, requester);
+  return 0;
+}
+
+// Relay task side of selectAntennas()
+static uint8_t runBatch(const AntennaSelection* selections, uint8_t count, TaskHandle_t requester) {
+  uint8_t target[MATRIX_RADIOS];
+  uint32_t listed = 0;
+  memcpy(target, currentAntenna, sizeof(target));
+
+  for(uint8_t i = 0; i < count; i++) {
+    uint8_t radio = selections[i].radio;
+    if(!Matrix::valid(radio, selections[i].antenna) || (listed & (1UL << radio)))
+      return 1;
+    listed |= 1UL << radio;
+    target[radio] = selections[i].antenna;
+  }
+
+  // Single radio mode - every radio but the first stays disconnected
+  if(singleRadioMode) {
+    for(uint8_t r = 1; r < MATRIX_RADIOS; r++)
+      target[r] = 0;
+  }
+
+  // The final assignment may not share an antenna between radios
+  Matrix::AntennaMask used = 0;
+  for(uint8_t r = 0; r < MATRIX_RADIOS; r++) {
+    if(target[r] == 0)
+      continue;
+    Matrix::AntennaMask bit = (Matrix::AntennaMask)1 << (target[r] - 1);
+    if(used & bit)
+      return 2;
+    used |= bit;
+  }
+
+  // One break and one make for all radios
+  applyAntennas(target, requester);
+  return 0;
+}
+
+static uint8_t runRequest(RelayRequest* req) {
+  switch(req->op) {
+    case RELAY_SELECT:
+      return runSelect(req->selections[0].radio, req->selections[0].antenna, req->waiter);
+    case RELAY_BATCH:
+      return runBatch(req->selections, req->count, req->waiter);
+    case RELAY_DISCONNECT: {
+      uint8_t target[MATRIX_RADIOS];
+      memcpy(target, currentAntenna, sizeof(target));
+      target[req->selections[0].radio] = 0;
+      applyAntennas(target, req->waiter);
+      return 0;
+    }
+    case RELAY_SINGLE_RADIO: {
+      uint8_t target[MATRIX_RADIOS];
+      memcpy(target, currentAntenna, sizeof(target));
+      for(uint8_t r = 1; r < MATRIX_RADIOS; r++)
+        target[r] = 0;
+      applyAntennas(target, req->waiter);
+      return 0;
+    }
+    case RELAY_DISCONNECT_ALL:
+      matrix.reset();
+      memset(currentAntenna, 0, sizeof(currentAntenna));
+      return 0;
+    case RELAY_SETTLE:
+      matrix.setSettleMs(req->selections[0].radio, req->selections[0].antenna, req->settleMs);
+      return 0;
+  }
+  return 1;
+}
+
+static void relayTaskLoop(void* arg) {
+  for(;;) {
+    uint32_t events = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &events, portMAX_DELAY);
+
+    if(events & RELAY_EVENT_TIMER)
+      matrix.onTimer();
+
+    RelayRequest* req;
+    while(relayRing.pop(req)) {
+      xSemaphoreGive(relaySlots);
+      req->result = runRequest(req);
+      TaskHandle_t waiter = req->waiter;
+      req->done = true;
+      xTaskNotifyGive(waiter);
+    }
+  }
+}
+
+// Queue a request for the relay task and wait for its result
+static uint8_t submit(RelayRequest& req) {
+  // Nothing can switch before initializeHardware()
+  if(relayTask == nullptr)
+    return 1;
+
+  req.waiter = xTaskGetCurrentTaskHandle();
+  if(relayInline)
+    return runRequest(&req);
+
+  // Holding a slot means the push cannot fail
+  req.done = false;
+  xSemaphoreTake(relaySlots, portMAX_DELAY);
+  relayRing.push(&req);
+  xTaskNotify(relayTask, RELAY_EVENT_COMMAND, eSetBits);
+
+  // A notification left over from elsewhere may wake us early
+  while(!req.done)
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  return req.result;
+}
 
 void initializeHardware() {
   // Initialize all relay control pins as outputs
-  for(uint8_t radio = 0; radio < 2; radio++) {
-    for(uint8_t antenna = 0; antenna < 6; antenna++) {
-      pinMode(relay[radio][antenna], OUTPUT);
-      digitalWrite(relay[radio][antenna], LOW);
+  for(uint8_t radio = 0; radio < MATRIX_RADIOS; radio++) {
+    for(uint8_t antenna = 0; antenna < MATRIX_ANTENNAS; antenna++) {
+      pinMode(relayPins[radio][antenna], OUTPUT);
     }
   }
+  halRelayPortBegin(relayTimerCallback);
+  matrix.reset();
+  relaySlots = xSemaphoreCreateCounting(RELAY_RING_SIZE, RELAY_RING_SIZE);
+  xTaskCreatePinnedToCore(relayTaskLoop, "relay", RELAY_TASK_STACK, nullptr,
+                          RELAY_TASK_PRIORITY, &relayTask, RELAY_TASK_CORE);
   
   // Initialize LED pins
   pinMode(STATUS_LED, OUTPUT);
@@ -17,82 +229,124 @@ void initializeHardware() {
 }
 
 void blink(uint8_t n) {
-  for(uint8_t i = 0; i < n; i++) {
+  if(n == 0)
+    return;
+
+  // Queue behind a running pattern, otherwise start right away
+  portENTER_CRITICAL(&blinkMux);
+  bool start = blinkPhases == 0;
+  uint32_t phases = blinkPhases + 2 * n;
+  blinkPhases = phases > 0xFFFE ? 0xFFFE : phases;
+  if(start)
+    blinkPhaseStart = millis();
+  portEXIT_CRITICAL(&blinkMux);
+
+  if(start)
     digitalWrite(STATUS_LED, 1);
-    delay(50);
-    digitalWrite(STATUS_LED, 0);
-    delay(50);  
+}
+
+void handleStatusLed() {
+  uint32_t now = millis();
+  portENTER_CRITICAL(&blinkMux);
+  if(blinkPhases == 0 || now - blinkPhaseStart < BLINK_PHASE_MS) {
+    portEXIT_CRITICAL(&blinkMux);
+    return;
   }
+  blinkPhaseStart = now;
+  uint16_t phases = --blinkPhases;
+  portEXIT_CRITICAL(&blinkMux);
+
+  // Odd phases remaining means the next one is an "on" phase
+  digitalWrite(STATUS_LED, phases & 1);
+}
+
+void disconnectRadio(uint8_t radio) {
+  RelayRequest req;
+  req.op = RELAY_DISCONNECT;
+  req.selections[0].radio = radio;
+  submit(req);
+}
+
+void disconnectOtherRadios() {
+  RelayRequest req;
+  req.op = RELAY_SINGLE_RADIO;
+  submit(req);
+}
+
+void disconnectAll() {
+  RelayRequest req;
+  req.op = RELAY_DISCONNECT_ALL;
+  submit(req);
+}
+
+uint32_t getLastSwitchCycles() {
+  return lastSwitchCycles;
+}
+
+uint16_t getRelaySettleMs(uint8_t radio, uint8_t antenna) {
+  return matrix.settleMs(radio, antenna);
+}
+
+void setRelaySettleMs(uint8_t radio, uint8_t antenna, uint16_t ms) {
+  // Before the relay task exists no one else reads the table
+  if(relayTask == nullptr) {
+    matrix.setSettleMs(radio, antenna, ms);
+    return;
+  }
+
+  RelayRequest req;
+  req.op = RELAY_SETTLE;
+  req.selections[0].radio = radio;
+  req.selections[0].antenna = antenna;
+  req.settleMs = ms;
+  submit(req);
+}
+
+SwitchTrace getSwitchTrace() {
+  return matrix.lastTrace();
+}
+
+void setRelayInline(bool enabled) {
+  relayInline = enabled;
 }
 
 uint8_t selectAntenna(uint8_t radio, uint8_t antenna) {
-  if(radio > 1 || antenna > 6) {
+  RelayRequest req;
+  req.op = RELAY_SELECT;
+  req.selections[0].radio = radio;
+  req.selections[0].antenna = antenna;
+
+  uint8_t result = submit(req);
+  if(result != 0) {
     blink(3);
-    return 1;
+    return result;
   }
   
-  // Single radio mode - always disconnect radio 2
-  if(singleRadioMode && radio == 1) {
-    if(currentAntenna[1] > 0) {
-      digitalWrite(relay[1][currentAntenna[1]-1], 0);
-      currentAntenna[1] = 0;
-    }
-    sendWebSocketUpdate();
-    blink(1);
-    return 0;
-  }
-  
-  // Check if antenna is already selected by the other radio (unless disconnecting)
-  if(antenna > 0) {
-    uint8_t otherRadio = (radio == 0) ? 1 : 0;
-    
-    if(currentAntenna[otherRadio] == antenna) {
-      // If antenna swapping is enabled, perform the swap
-      if(antennaSwappingEnabled) {
-        uint8_t previousAntenna = currentAntenna[radio];
-        
-        // Step 1: Disconnect the other radio
-        digitalWrite(relay[otherRadio][antenna-1], 0);
-        
-        // Step 2: Connect the first radio to the desired antenna
-        if(currentAntenna[radio] > 0) {
-          digitalWrite(relay[radio][currentAntenna[radio]-1], 0);
-        }
-        digitalWrite(relay[radio][antenna-1], 1);
-        currentAntenna[radio] = antenna;
-        
-        // Step 3: Connect the other radio to the antenna that was used by the first radio
-        if(previousAntenna > 0 && !singleRadioMode) {
-          digitalWrite(relay[otherRadio][previousAntenna-1], 1);
-          currentAntenna[otherRadio] = previousAntenna;
-        } else {
-          currentAntenna[otherRadio] = 0;
-        }
-        
-        sendWebSocketUpdate();
-        blink(1);
-        return 0;
-      } else {
-        // Antenna swapping disabled - return busy error
-        blink(3);
-        return 2;
-      }
-    }
-  }
-   
-  // Turn off current antenna relay
-  if(currentAntenna[radio] > 0)
-    digitalWrite(relay[radio][currentAntenna[radio]-1], 0);
-  
-  // Turn on new antenna relay (if not disconnecting)
-  if(antenna > 0) 
-    digitalWrite(relay[radio][antenna-1], 1);
-  
-  currentAntenna[radio] = antenna;
-  
   // Send WebSocket update
   sendWebSocketUpdate();
   
   blink(1);
   return 0;
 }
+
+uint8_t selectAntennas(const AntennaSelection* selections, uint8_t count) {
+  if(count > MATRIX_RADIOS) {
+    blink(3);
+    return 1;
+  }
+
+  RelayRequest req;
+  req.op = RELAY_BATCH;
+  req.count = count;
+  memcpy(req.selections, selections, count * sizeof(AntennaSelection));
+
+  uint8_t result = submit(req);
+  if(result != 0) {
+    blink(3);
+    return result;
+  }
+
+  sendWebSocketUpdate();
+  blink(1);
+  return 0;
+}
@@ -0,0 +1,117 @@
+#include "band_index.h"
+#include "globals.h"
+#include "antenna_hardware.h"
+
+struct BandRange {
+  const char* name;
+  uint32_t lowKHz;
+  uint32_t highKHz;
+};
+
+// Indexed by BandId
+static const BandRange bandTable[BAND_COUNT] = {
+  {"160m",  1800,  2000},
+  {"80m",   3500,  4000},
+  {"60m",   5250,  5450},
+  {"40m",   7000,  7300},
+  {"30m",  10100, 10150},
+  {"20m",  14000, 14350},
+  {"17m",  18068, 18168},
+  {"15m",  21000, 21450},
+  {"12m",  24890, 24990},
+  {"10m",  28000, 29700},
+  {"6m",   50000, 54000}
+};
+
+static Matrix::AntennaMask bandIndex[BAND_COUNT];
+
+void rebuildBandIndex() {
+  Matrix::AntennaMask index[BAND_COUNT] = {};
+
+  for(uint8_t a = 0; a < MATRIX_ANTENNAS; a++) {
+    for(const auto& band : antennas[a].bands) {
+      uint8_t id = bandFromName(band.c_str());
+      if(id != BAND_NONE)
+        index[id] |= (Matrix::AntennaMask)1 << a;
+    }
+  }
+  memcpy(bandIndex, index, sizeof(bandIndex));
+}
+
+Matrix::AntennaMask bandAntennas(uint8_t band) {
+  return band < BAND_COUNT ? bandIndex[band] : 0;
+}
+
+uint8_t bandFromName(const char* name) {
+  for(uint8_t i = 0; i < BAND_COUNT; i++) {
+    if(strcasecmp(name, bandTable[i].name) == 0)
+      return i;
+  }
+  return BAND_NONE;
+}
+
+uint8_t bandFromReport(const char* report) {
+  const char* p = report;
+  uint32_t mhz = 0;
+  uint32_t khz = 0;
+
+  if(*p < '0' || *p > '9')
+    return BAND_NONE;
+  while(*p >= '0' && *p <= '9')
+    mhz = mhz * 10 + (*p++ - '0');
+
+  if(*p == 'm' || *p == 'M')
+    return bandFromName(report);
+
+  bool whole = *p != '.';
+  if(!whole) {
+    p++;
+    for(uint32_t scale = 100; scale > 0; scale /= 10) {
+      if(*p < '0' || *p > '9')
+        break;
+      khz += (*p++ - '0') * scale;
+    }
+  }
+
+  uint32_t freqKHz = mhz * 1000 + khz;
+  for(uint8_t i = 0; i < BAND_COUNT; i++) {
+    if(freqKHz >= bandTable[i].lowKHz && freqKHz <= bandTable[i].highKHz)
+      return i;
+  }
+
+  // Whole-MHz reports name the band by its lower edge ("1" = 160m, "3" = 80m)
+  if(whole) {
+    for(uint8_t i = 0; i < BAND_COUNT; i++) {
+      if(mhz == bandTable[i].lowKHz / 1000)
+        return i;
+    }
+  }
+  return BAND_NONE;
+}
+
+const char* bandName(uint8_t band) {
+  return band < BAND_COUNT ? bandTable[band].name : "";
+}
+
+uint8_t selectAntennaForBand(uint8_t radio, uint8_t band) {
+  Matrix::AntennaMask allowed = bandAntennas(band);
+  if(allowed == 0 || radio >= MATRIX_RADIOS)
+    return 0;
+
+  uint8_t current = currentAntenna[radio];
+  if(current > 0 && (allowed & ((Matrix::AntennaMask)1 << (current - 1))))
+    return current;
+
+  Matrix::AntennaMask used = 0;
+  for(uint8_t r = 0; r < MATRIX_RADIOS; r++) {
+    if(r != radio && currentAntenna[r] > 0)
+      used |= (Matrix::AntennaMask)1 << (currentAntenna[r] - 1);
+  }
+
+  Matrix::AntennaMask available = allowed & ~used;
+  if(available == 0)
+    return 0;
+
+  uint8_t antenna = __builtin_ctz(available) + 1;
+  return selectAntenna(radio, antenna) == 0 ? antenna : 0;
+}
@@ -1,18 +1,44 @@
 #include "command_parser.h"
 #include "globals.h"
 #include "antenna_hardware.h"
+#include "latency_stats.h"
+#include "band_index.h"
+
+// Radio or antenna number from a command argument, 0xFF if missing or
+// out of range
+static uint8_t parseNumber(const char* arg) {
+  if(!arg)
+    return 0xFF;
+  int value = atoi(arg);
+  return (value < 0 || value > 0xFF) ? 0xFF : value;
+}
 
 void parseCommand(char* commandLine, Stream& responseStream) {
   char* cmd = strsep(&commandLine, " ");
   
   if(strcmp(cmd, "blink") == 0) {
-    int num = atoi(strsep(&commandLine, " "));
-    blink(num);
+    const char* n = strsep(&commandLine, " ");
+    blink(n ? atoi(n) : 0);
   } 
   else if(strcmp(cmd, "set") == 0) {
-    int r = atoi(strsep(&commandLine, " "));
-    int a = atoi(strsep(&commandLine, " "));
-    int result = selectAntenna(r-1, a);
+    // set <radio> <antenna> [<radio> <antenna> ...]
+    AntennaSelection selections[MATRIX_RADIOS + 1];
+    uint8_t count = 0;
+    char* r;
+    char* a;
+    while(count <= MATRIX_RADIOS && (r = strsep(&commandLine, " ")) && (a = strsep(&commandLine, " "))) {
+      selections[count].radio = parseNumber(r) - 1;
+      selections[count].antenna = parseNumber(a);
+      count++;
+    }
+
+    int result;
+    if(count == 1)
+      result = selectAntenna(selections[0].radio, selections[0].antenna);
+    else if(count > 1 && count <= MATRIX_RADIOS)
+      result = selectAntennas(selections, count);
+    else
+      result = 1;
     if(result == 0)
       responseStream.println("+OK");
     else if(result == 1)
@@ -21,15 +47,47 @@ void parseCommand(char* commandLine, Stream& responseStream) {
       responseStream.println("!BUSY");
   }
   else if(strcmp(cmd, "get") == 0) {
-    int r = atoi(strsep(&commandLine, " "));
-    responseStream.println(currentAntenna[r-1]);
+    uint8_t r = parseNumber(strsep(&commandLine, " "));
+    if(r >= 1 && r <= MATRIX_RADIOS)
+      responseStream.println(currentAntenna[r-1]);
+    else
+      responseStream.println("!ERR");
+  }
+  else if(strcmp(cmd, "band") == 0) {
+    // band <radio> <band|MHz>
+    const char* r = strsep(&commandLine, " ");
+    const char* b = strsep(&commandLine, " ");
+    uint8_t radio = parseNumber(r) - 1;
+    uint8_t band = b ? bandFromReport(b) : BAND_NONE;
+    if(radio >= MATRIX_RADIOS || band == BAND_NONE) {
+      responseStream.println("!ERR");
+      return;
+    }
+    uint8_t antenna = selectAntennaForBand(radio, band);
+    if(antenna > 0)
+      responseStream.printf("+OK %u\n", antenna);
+    else
+      responseStream.println("!BUSY");
   }
   else if(strcmp(cmd, "?") == 0) {
-    responseStream.println("6x2 Antenna Switch SQ9NJE");
+    responseStream.println(DEVICE_NAME);
+  }
+  else if(strcmp(cmd, "stats") == 0) {
+    const char* arg = strsep(&commandLine, " ");
+    if(arg && strcmp(arg, "reset") == 0) {
+      latencyReset();
+      responseStream.println("+OK");
+      return;
+    }
+    for(uint8_t s = 0; s < LATENCY_SOURCES; s++) {
+      LatencySummary sum = latencySummary((LatencySource)s);
+      responseStream.printf("%s n=%u p50=%uus p99=%uus max=%uus\n",
+        latencySourceName((LatencySource)s), sum.count, sum.p50Us, sum.p99Us, sum.maxUs);
+    }
   }
   else if(strcmp(cmd, "test") == 0) {
-    for(uint8_t r = 0; r < 2; r++)
-      for(int8_t a = 6; a >= 0; a--) {
+    for(uint8_t r = 0; r < MATRIX_RADIOS; r++)
+      for(int8_t a = MATRIX_ANTENNAS; a >= 0; a--) {
         selectAntenna(r, a);
         delay(100);
       }
@@ -37,14 +95,22 @@ void parseCommand(char* commandLine, Stream& responseStream) {
 }
 
 void handleSerialInput(Stream& serial, Stream& responseStream) {
+  LatencySource source = (&serial == &Serial) ? LATENCY_USB : LATENCY_UART2;
+
   while(serial.available()) {
     static char buffer[BUF_SIZE];
     static uint8_t len = 0;
+    static uint32_t lineStart = 0;
+
+    if(len == 0)
+      lineStart = micros();
 
     char data = serial.read();
     if(data == '\r' || data == '\n') {
       buffer[len] = '\0';
+      latencyBegin(source, lineStart);
       parseCommand(buffer, responseStream);
+      latencyEnd();
       len = 0;
     }
     else if(len < BUF_SIZE-1)
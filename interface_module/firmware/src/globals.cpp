@@ -1,20 +1,14 @@
 #include "globals.h"
-#include <ESPAsyncWebServer.h>
-#include <WebSocketsServer.h>
+#include "uart2.h"
 
 // Global variables definitions
-uint8_t currentAntenna[2] = {0, 0}; // 0 means disconnected
-const uint8_t relay[2][6] = {{13, 12, 14, 27, 26, 25}, {5, 18, 19, 21, 22, 23}};
-AntennaConfig antennas[6] = {
-    {"Antenna 1", {}}, {"Antenna 2", {}}, {"Antenna 3", {}},
-    {"Antenna 4", {}}, {"Antenna 5", {}}, {"Antenna 6", {}}
-};
+uint8_t currentAntenna[MATRIX_RADIOS] = {}; // 0 means disconnected
+AntennaConfig antennas[MATRIX_ANTENNAS];  // default names set by loadSettings()
 String mdnsHostname = "antenna";
 bool antennaSwappingEnabled = false;
 bool singleRadioMode = false;
 bool otrspEnabled = false;
 bool otrspSerialEnabled = false;
-
-// Global objects
-AsyncWebServer server(80);
-WebSocketsServer webSocket = WebSocketsServer(81);
+bool bandAutoSelect = false;
+uint32_t serialBaud = UART2_DEFAULT_BAUD;
+bool serialAutobaud = false;
@@ -0,0 +1,61 @@
+#include "hal.h"
+#include <Arduino.h>
+#include <soc/gpio_struct.h>
+#include <esp_timer.h>
+
+static void (*timerHandler)() = nullptr;
+
+static void relayTimerCallback(void* arg) {
+  if(timerHandler)
+    timerHandler();
+}
+
+// Writes straight to the GPIO set/clear registers, one store per bank,
+// and times the settle wait with a one-shot esp_timer
+class Esp32RelayPort : public RelayPort {
+public:
+  void begin() {
+    esp_timer_create_args_t args = {};
+    args.callback = relayTimerCallback;
+    args.name = "relay_settle";
+    esp_timer_create(&args, &timer_);
+  }
+
+  void write(uint64_t setMask, uint64_t clearMask) override {
+    if((uint32_t)clearMask) GPIO.out_w1tc = (uint32_t)clearMask;
+    if(clearMask >> 32) GPIO.out1_w1tc.val = (uint32_t)(clearMask >> 32);
+    if((uint32_t)setMask) GPIO.out_w1ts = (uint32_t)setMask;
+    if(setMask >> 32) GPIO.out1_w1ts.val = (uint32_t)(setMask >> 32);
+  }
+
+  uint64_t nowUs() override {
+    return esp_timer_get_time();
+  }
+
+  void schedule(uint32_t delayUs) override {
+    esp_timer_stop(timer_);
+    esp_timer_start_once(timer_, delayUs);
+  }
+
+  void lock() override { portENTER_CRITICAL(&mux_); }
+  void unlock() override { portEXIT_CRITICAL(&mux_); }
+
+private:
+  esp_timer_handle_t timer_ = nullptr;
+  portMUX_TYPE mux_ = portMUX_INITIALIZER_UNLOCKED;
+};
+
+// Constructed on first use, the matrix binds to it during static init
+static Esp32RelayPort& esp32RelayPort() {
+  static Esp32RelayPort port;
+  return port;
+}
+
+RelayPort& halRelayPort() {
+  return esp32RelayPort();
+}
+
+void halRelayPortBegin(void (*onTimer)()) {
+  timerHandler = onTimer;
+  esp32RelayPort().begin();
+}
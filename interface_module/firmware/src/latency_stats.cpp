@@ -0,0 +1,155 @@
+#include "latency_stats.h"
+
+// Log-linear histogram: exact below 4 us, then 4 buckets per power of
+// two (<= 25% error) up to 2^24 us. Samples beyond that clamp into the
+// last bucket, the exact maximum is kept separately.
+#define LATENCY_SUB_BITS  2
+#define LATENCY_MAX_MSB   23
+#define LATENCY_BUCKETS   (LATENCY_MAX_MSB << LATENCY_SUB_BITS)
+
+struct LatencyHistogram {
+  uint32_t buckets[LATENCY_BUCKETS];
+  uint32_t count;
+  uint32_t maxUs;
+};
+
+// Tasks that can have a command open at the same time: loop() (USB,
+// UART2) and AsyncTCP (OTRSP TCP, WebSocket, REST), with room to spare
+#define LATENCY_TASK_SLOTS 4
+
+// A command in flight, one per task
+struct PendingCommand {
+  TaskHandle_t task;  // nullptr = slot free
+  LatencySource source;
+  uint32_t startUs;
+};
+
+static LatencyHistogram histograms[LATENCY_SOURCES];
+static PendingCommand pending[LATENCY_TASK_SLOTS];
+// Guards the histograms and the pending slots
+static portMUX_TYPE histogramMux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint16_t bucketIndex(uint32_t us) {
+  if(us < (1 << LATENCY_SUB_BITS))
+    return us;
+  uint8_t msb = 31 - __builtin_clz(us);
+  if(msb > LATENCY_MAX_MSB)
+    return LATENCY_BUCKETS - 1;
+  uint8_t sub = (us >> (msb - LATENCY_SUB_BITS)) & ((1 << LATENCY_SUB_BITS) - 1);
+  return ((msb - 1) << LATENCY_SUB_BITS) + sub;
+}
+
+static uint32_t bucketUpperUs(uint16_t index) {
+  if(index < (1 << LATENCY_SUB_BITS))
+    return index;
+  uint8_t msb = (index >> LATENCY_SUB_BITS) + 1;
+  uint8_t sub = index & ((1 << LATENCY_SUB_BITS) - 1);
+  uint8_t shift = msb - LATENCY_SUB_BITS;
+  return (((1 << LATENCY_SUB_BITS) + sub + 1) << shift) - 1;
+}
+
+void latencyBegin(LatencySource source, uint32_t startUs) {
+  TaskHandle_t task = xTaskGetCurrentTaskHandle();
+
+  // Reuse this task's slot, else take a free one; with all slots busy
+  // the command is not measured
+  portENTER_CRITICAL(&histogramMux);
+  PendingCommand* slot = nullptr;
+  for(uint8_t i = 0; i < LATENCY_TASK_SLOTS; i++) {
+    if(pending[i].task == task) {
+      slot = &pending[i];
+      break;
+    }
+    if(!slot && pending[i].task == nullptr)
+      slot = &pending[i];
+  }
+  if(slot) {
+    slot->task = task;
+    slot->source = source;
+    slot->startUs = startUs;
+  }
+  portEXIT_CRITICAL(&histogramMux);
+}
+
+void latencyEnd() {
+  TaskHandle_t task = xTaskGetCurrentTaskHandle();
+
+  portENTER_CRITICAL(&histogramMux);
+  for(uint8_t i = 0; i < LATENCY_TASK_SLOTS; i++) {
+    if(pending[i].task == task)
+      pending[i].task = nullptr;
+  }
+  portEXIT_CRITICAL(&histogramMux);
+}
+
+void latencyMarkSwitch(TaskHandle_t requester) {
+  if(requester == nullptr)
+    return;
+  uint32_t now = micros();
+
+  // Take the requester's open command, if any, and record it in one go
+  portENTER_CRITICAL(&histogramMux);
+  for(uint8_t i = 0; i < LATENCY_TASK_SLOTS; i++) {
+    if(pending[i].task != requester)
+      continue;
+
+    uint32_t us = now - pending[i].startUs;
+    LatencyHistogram& h = histograms[pending[i].source];
+    pending[i].task = nullptr;
+    h.buckets[bucketIndex(us)]++;
+    h.count++;
+    if(us > h.maxUs)
+      h.maxUs = us;
+    break;
+  }
+  portEXIT_CRITICAL(&histogramMux);
+}
+
+LatencySummary latencySummary(LatencySource source) {
+  LatencyHistogram snapshot;
+  LatencySummary summary = {0, 0, 0, 0};
+
+  portENTER_CRITICAL(&histogramMux);
+  snapshot = histograms[source];
+  portEXIT_CRITICAL(&histogramMux);
+
+  summary.count = snapshot.count;
+  summary.maxUs = snapshot.maxUs;
+  if(snapshot.count == 0)
+    return summary;
+
+  // Ranks are 1-based: the p-th percentile is the ceil(p * n)-th sample
+  uint32_t rank50 = ((uint64_t)snapshot.count * 50 + 99) / 100;
+  uint32_t rank99 = ((uint64_t)snapshot.count * 99 + 99) / 100;
+  uint32_t seen = 0;
+  bool have50 = false;
+  for(uint16_t i = 0; i < LATENCY_BUCKETS; i++) {
+    seen += snapshot.buckets[i];
+    if(!have50 && seen >= rank50) {
+      have50 = true;
+      summary.p50Us = min(bucketUpperUs(i), snapshot.maxUs);
+    }
+    if(seen >= rank99) {
+      summary.p99Us = min(bucketUpperUs(i), snapshot.maxUs);
+      break;
+    }
+  }
+  return summary;
+}
+
+const char* latencySourceName(LatencySource source) {
+  switch(source) {
+    case LATENCY_USB:       return "usb";
+    case LATENCY_UART2:     return "uart2";
+    case LATENCY_OTRSP_TCP: return "otrspTcp";
+    case LATENCY_WEBSOCKET: return "websocket";
+    case LATENCY_REST:      return "rest";
+    default:                return "unknown";
+  }
+}
+
+void latencyReset() {
+  portENTER_CRITICAL(&histogramMux);
+  memset(histograms, 0, sizeof(histograms));
+  portEXIT_CRITICAL(&histogramMux);
+}
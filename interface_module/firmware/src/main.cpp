@@ -2,7 +2,6 @@
 #include <WiFi.h>
 #include <WiFiManager.h>
 #include <ESPAsyncWebServer.h>
-#include <WebSocketsServer.h>
 #include <ArduinoJson.h>
 #include <SPIFFS.h>
 #include <ESPmDNS.h>
@@ -17,6 +16,7 @@
 #include "web_server.h"
 #include "wifi_manager.h"
 #include "otrsp.h"
+#include "uart2.h"
 
 void initializeOTA() {
   ArduinoOTA.setHostname(mdnsHostname.c_str());
@@ -33,21 +33,18 @@ void initializeOTA() {
     Serial.println("Start updating " + type);
     
     // Turn off all relays during OTA
-    for(uint8_t radio = 0; radio < 2; radio++) {
-      for(uint8_t antenna = 0; antenna < 6; antenna++) {
-        digitalWrite(relay[radio][antenna], LOW);
-      }
-    }
-    currentAntenna[0] = 0;
-    currentAntenna[1] = 0;
+    disconnectAll();
     
-    // Notify connected clients
+    // Notify connected clients; loop() is blocked until the update ends,
+    // so OTA frames are sent from the callbacks
     sendOTAStatus("starting", type, 0);
+    handleWebSocketBroadcasts(true);
   });
   
   ArduinoOTA.onEnd([]() {
     Serial.println("\nOTA Update complete");
     sendOTAStatus("complete", "", 100);
+    handleWebSocketBroadcasts(true);
     delay(1000);
   });
   
@@ -55,6 +52,7 @@ void initializeOTA() {
     unsigned int percent = (progress / (total / 100));
     Serial.printf("Progress: %u%%\r", percent);
     sendOTAStatus("progress", "", percent);
+    handleWebSocketBroadcasts();
   });
   
   ArduinoOTA.onError([](ota_error_t error) {
@@ -77,6 +75,7 @@ void initializeOTA() {
       Serial.println("End Failed");
     }
     sendOTAStatus("error", errorMsg, 0);
+    handleWebSocketBroadcasts(true);
   });
   
   ArduinoOTA.begin();
@@ -88,13 +87,13 @@ void initializeOTA() {
 
 void setup() {
   Serial.begin(115200);
-  Serial2.begin(9600, SERIAL_8N1, RXD2, TXD2);
   
-  Serial.println("Starting 6x2 Antenna Switch SQ9NJE");
+  Serial.println("Starting " DEVICE_NAME);
 
-  // Initialize storage
+  // Initialize storage. Without it settings are not kept, but switching
+  // and (with WEB_ASSETS_EMBEDDED) the web UI still work.
   if(!initializeStorage()) {
-    return;
+    Serial.println("Continuing with default settings");
   }
 
   // Initialize hardware
@@ -103,6 +102,9 @@ void setup() {
   // Load settings
   loadSettings();
 
+  // Open UART2 at the stored (or detected) rate
+  initializeUART2();
+
   // Initialize network
   initializeWiFi();
   initializeMDNS();
@@ -125,7 +127,8 @@ void setup() {
 
 void loop() {
   ArduinoOTA.handle();
-  webSocket.loop();
+  handleWebSocketBroadcasts();
+  handleStatusLed();
   
   // Handle OTRSP TCP + serial
   handleOTRSPLoop();
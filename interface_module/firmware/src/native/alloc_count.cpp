@@ -0,0 +1,41 @@
+#include "bench.h"
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+// Global allocation counter for the benchmarks; String and std::vector
+// allocate through operator new on the host as on the ESP32
+
+static std::atomic<uint64_t> allocations(0);
+
+uint64_t nativeAllocCount() {
+  return allocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  void* p = malloc(size ? size : 1);
+  if(!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+  free(p);
+}
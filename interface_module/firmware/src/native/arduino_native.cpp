@@ -0,0 +1,127 @@
+#include <Arduino.h>
+#include <stdarg.h>
+#include <chrono>
+#include <thread>
+
+static const std::chrono::steady_clock::time_point bootTime = std::chrono::steady_clock::now();
+
+volatile uint8_t nativeGpioLevel[NATIVE_GPIOS];
+
+HostSerial Serial(stdin, stdout);
+HostSerial Serial2(nullptr, nullptr);
+EspClass ESP;
+
+uint32_t millis() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now() - bootTime).count();
+}
+
+uint32_t micros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - bootTime).count();
+}
+
+void delay(uint32_t ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+  if(pin < NATIVE_GPIOS)
+    nativeGpioLevel[pin] = level ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < NATIVE_GPIOS ? nativeGpioLevel[pin] : LOW;
+}
+
+// Host nanoseconds stand in for the 240 MHz CPU cycle counter
+uint32_t EspClass::getCycleCount() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - bootTime).count();
+}
+
+void String::trim() {
+  size_t start = s_.find_first_not_of(" \t\r\n");
+  size_t end = s_.find_last_not_of(" \t\r\n");
+  s_ = start == std::string::npos ? std::string() : s_.substr(start, end - start + 1);
+}
+
+int String::indexOf(char c, unsigned int from) const {
+  size_t pos = s_.find(c, from);
+  return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+  if(from > s_.length())
+    return String();
+  return String(s_.substr(from, to > from ? to - from : 0));
+}
+
+String operator+(const String& a, const String& b) { String s(a); s += b; return s; }
+String operator+(const String& a, const char* b) { String s(a); s += b; return s; }
+String operator+(const char* a, const String& b) { String s(a); s += b; return s; }
+String operator+(const String& a, char b) { String s(a); s += b; return s; }
+String operator+(const String& a, int b) { return a + String(b); }
+String operator+(const String& a, unsigned int b) { return a + String(b); }
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t n = 0;
+  while(size--)
+    n += write(*buffer++);
+  return n;
+}
+
+size_t Print::printf(const char* format, ...) {
+  char buffer[256];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  if(len < 0)
+    return 0;
+  return write((const uint8_t*)buffer, min<size_t>(len, sizeof(buffer) - 1));
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+  size_t n = 0;
+  while(n < length) {
+    int c = read();
+    if(c < 0)
+      break;
+    buffer[n++] = c;
+  }
+  return n;
+}
+
+// stdin is read blocking: there is always a byte until end of input
+int HostSerial::available() {
+  return peek() >= 0 ? 1 : 0;
+}
+
+int HostSerial::read() {
+  return in_ ? getc(in_) : -1;
+}
+
+int HostSerial::peek() {
+  if(!in_)
+    return -1;
+  int c = getc(in_);
+  if(c != EOF)
+    ungetc(c, in_);
+  return c == EOF ? -1 : c;
+}
+
+size_t HostSerial::write(uint8_t c) {
+  return out_ ? fputc(c, out_) != EOF : 1;
+}
+
+size_t HostSerial::write(const uint8_t* buffer, size_t size) {
+  return out_ ? fwrite(buffer, 1, size, out_) : size;
+}
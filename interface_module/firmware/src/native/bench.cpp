@@ -0,0 +1,166 @@
+#include "bench.h"
+#include <Arduino.h>
+#include <chrono>
+#include "globals.h"
+#include "antenna_hardware.h"
+#include "command_parser.h"
+#include "otrsp.h"
+
+// Parser throughput on realistic command mixes. Each mix is run as
+// parser calls into a byte-counting sink; AUX and set lines really
+// switch, with relay settle times at 0 so no make step is deferred.
+// Switches run inline on the bench thread so the rows time the parsers;
+// native-set-task sends the same lines through the relay task, its
+// difference to native-set is the cost of the task handoff.
+
+#define BENCH_DEFAULT_ITERATIONS  100000
+#define BENCH_LINE_SIZE           64
+
+enum BenchParser { BENCH_OTRSP, BENCH_NATIVE };
+
+struct BenchMix {
+  const char* name;
+  BenchParser parser;
+  const char* const* lines;
+  uint8_t count;
+  bool relayTask;  // switch through the relay task instead of inline
+};
+
+struct BenchResult {
+  uint64_t nsTotal;
+  uint64_t allocations;
+  uint64_t responseBytes;
+};
+
+// Contest logger traffic: antenna changes, state polls, band/mode reports
+static const char* const otrspAux[] = {"AUX11", "AUX22", "AUX13", "AUX24", "AUX10", "AUX20"};
+static const char* const otrspQuery[] = {"?AUX1", "?AUX2", "?TX", "?RX", "?NAME", "?FW", "?"};
+static const char* const otrspBandMode[] = {"BAND114.025", "MODE1C", "BAND27.010", "MODE2U", "TX1", "RX1S", "TX2", "RX2"};
+static const char* const otrspJunk[] = {"", "XYZZY", "AUX9", "?BOGUS", "AUX1", "BAND3", "MODE", "TX7"};
+static const char* const nativeSet[] = {"set 1 1", "set 2 2", "set 1 3", "set 2 4", "set 1 0", "set 2 0"};
+static const char* const nativeQuery[] = {"get 1", "get 2", "?"};
+static const char* const nativeJunk[] = {"", "hello", "get", "get 9", "set 9 9", "set 1"};
+
+#define BENCH_MIX(name, parser, lines) {name, parser, lines, sizeof(lines) / sizeof(lines[0]), false}
+#define BENCH_MIX_TASK(name, parser, lines) {name, parser, lines, sizeof(lines) / sizeof(lines[0]), true}
+
+static const BenchMix mixes[] = {
+  BENCH_MIX("otrsp-aux", BENCH_OTRSP, otrspAux),
+  BENCH_MIX("otrsp-query", BENCH_OTRSP, otrspQuery),
+  BENCH_MIX("otrsp-band-mode", BENCH_OTRSP, otrspBandMode),
+  BENCH_MIX("otrsp-junk", BENCH_OTRSP, otrspJunk),
+  BENCH_MIX("native-set", BENCH_NATIVE, nativeSet),
+  BENCH_MIX_TASK("native-set-task", BENCH_NATIVE, nativeSet),
+  BENCH_MIX("native-query", BENCH_NATIVE, nativeQuery),
+  BENCH_MIX("native-junk", BENCH_NATIVE, nativeJunk)
+};
+
+// Swallows responses, counting bytes so the output is not optimized away
+class NullStream : public Stream {
+public:
+  uint64_t bytes = 0;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  size_t write(uint8_t c) override { bytes++; return 1; }
+  size_t write(const uint8_t* buffer, size_t size) override { bytes += size; return size; }
+  using Print::write;
+};
+
+static void resetState() {
+  for(uint8_t r = 0; r < MATRIX_RADIOS; r++)
+    selectAntenna(r, 0);
+}
+
+static BenchResult runMix(const BenchMix& mix, uint32_t iterations) {
+  NullStream sink;
+  char line[BENCH_LINE_SIZE];
+
+  setRelayInline(!mix.relayTask);
+  resetState();
+  uint64_t allocStart = nativeAllocCount();
+  auto start = std::chrono::steady_clock::now();
+
+  for(uint32_t i = 0; i < iterations; i++) {
+    const char* src = mix.lines[i % mix.count];
+    if(mix.parser == BENCH_OTRSP) {
+      parseOTRSPCommand(src, sink);
+    } else {
+      // parseCommand() tokenizes in place
+      strncpy(line, src, sizeof(line) - 1);
+      line[sizeof(line) - 1] = '\0';
+      parseCommand(line, sink);
+    }
+  }
+
+  auto end = std::chrono::steady_clock::now();
+  setRelayInline(false);
+  BenchResult result;
+  result.nsTotal = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+  result.allocations = nativeAllocCount() - allocStart;
+  result.responseBytes = sink.bytes;
+  return result;
+}
+
+int runBenchmarks(int argc, char** argv) {
+  uint32_t iterations = BENCH_DEFAULT_ITERATIONS;
+  const char* outPath = nullptr;
+  const char* filter = nullptr;
+
+  for(int i = 2; i < argc; i++) {
+    if(strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+      iterations = strtoul(argv[++i], nullptr, 10);
+    else if(strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+      outPath = argv[++i];
+    else if(strcmp(argv[i], "--mix") == 0 && i + 1 < argc)
+      filter = argv[++i];
+    else {
+      fprintf(stderr, "usage: %s --bench [--iterations N] [--mix NAME] [--out FILE.json]\n", argv[0]);
+      return 2;
+    }
+  }
+  if(iterations == 0)
+    iterations = 1;
+
+  for(uint8_t r = 0; r < MATRIX_RADIOS; r++)
+    for(uint8_t a = 0; a < MATRIX_ANTENNAS; a++)
+      setRelaySettleMs(r, a, 0);
+  antennaSwappingEnabled = true;
+
+  FILE* out = nullptr;
+  if(outPath) {
+    out = fopen(outPath, "w");
+    if(!out) {
+      perror(outPath);
+      return 1;
+    }
+    fprintf(out, "{\n  \"iterations\": %u,\n  \"results\": [", iterations);
+  }
+
+  printf("%-16s %14s %12s %14s\n", "mix", "commands/s", "ns/command", "allocs/command");
+  bool first = true;
+  for(const BenchMix& mix : mixes) {
+    if(filter && strcmp(filter, mix.name) != 0)
+      continue;
+
+    BenchResult r = runMix(mix, iterations);
+    double nsPerCommand = (double)r.nsTotal / iterations;
+    double perSecond = r.nsTotal ? iterations * 1e9 / r.nsTotal : 0;
+    double allocsPerCommand = (double)r.allocations / iterations;
+    printf("%-16s %14.0f %12.1f %14.2f\n", mix.name, perSecond, nsPerCommand, allocsPerCommand);
+
+    if(out) {
+      fprintf(out, "%s\n    {\"mix\": \"%s\", \"commandsPerSec\": %.0f, \"nsPerCommand\": %.1f, "
+                   "\"allocsPerCommand\": %.3f, \"responseBytes\": %llu}",
+              first ? "" : ",", mix.name, perSecond, nsPerCommand, allocsPerCommand,
+              (unsigned long long)r.responseBytes);
+    }
+    first = false;
+  }
+
+  if(out) {
+    fprintf(out, "\n  ]\n}\n");
+    fclose(out);
+  }
+  return 0;
+}
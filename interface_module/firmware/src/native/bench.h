@@ -0,0 +1,15 @@
+#ifndef NATIVE_BENCH_H
+#define NATIVE_BENCH_H
+
+#include <stdint.h>
+
+// operator new calls since start, counted by alloc_count.cpp
+uint64_t nativeAllocCount();
+
+/**
+ * @brief Run the parser benchmarks (simulator --bench)
+ * @return Process exit code
+ */
+int runBenchmarks(int argc, char** argv);
+
+#endif
@@ -0,0 +1,138 @@
+#include <Arduino.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+struct NativeTask {
+  std::mutex lock;
+  std::condition_variable wake;
+  uint32_t value = 0;
+  bool pending = false;
+};
+
+struct NativeSemaphore {
+  std::mutex lock;
+  std::condition_variable wake;
+  UBaseType_t count;
+  UBaseType_t maxCount;
+};
+
+static thread_local NativeTask* currentTask = nullptr;
+static std::recursive_mutex criticalLock;
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  // Threads not started through xTaskCreatePinnedToCore (main) get a
+  // task on first use
+  if(!currentTask)
+    currentTask = new NativeTask();
+  return currentTask;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char* name, uint32_t stackDepth,
+                                   void* param, UBaseType_t priority, TaskHandle_t* created,
+                                   BaseType_t core) {
+  NativeTask* task = new NativeTask();
+  if(created)
+    *created = task;
+  std::thread([task, code, param]() {
+    currentTask = task;
+    code(param);
+  }).detach();
+  return pdPASS;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+  std::lock_guard<std::mutex> guard(task->lock);
+  switch(action) {
+    case eSetBits: task->value |= value; break;
+    case eIncrement: task->value++; break;
+    case eSetValueWithOverwrite: task->value = value; break;
+    case eSetValueWithoutOverwrite:
+      if(task->pending)
+        return pdFALSE;
+      task->value = value;
+      break;
+    case eNoAction: break;
+  }
+  task->pending = true;
+  task->wake.notify_all();
+  return pdPASS;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  return xTaskNotify(task, 0, eIncrement);
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t* value,
+                           TickType_t ticksToWait) {
+  NativeTask* task = xTaskGetCurrentTaskHandle();
+  std::unique_lock<std::mutex> guard(task->lock);
+  if(!task->pending)
+    task->value &= ~clearOnEntry;
+  if(ticksToWait == portMAX_DELAY)
+    task->wake.wait(guard, [task]() { return task->pending; });
+  else
+    task->wake.wait_for(guard, std::chrono::milliseconds(ticksToWait), [task]() { return task->pending; });
+  if(value)
+    *value = task->value;
+  if(!task->pending)
+    return pdFALSE;
+  task->pending = false;
+  task->value &= ~clearOnExit;
+  return pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait) {
+  NativeTask* task = xTaskGetCurrentTaskHandle();
+  std::unique_lock<std::mutex> guard(task->lock);
+  if(ticksToWait == portMAX_DELAY)
+    task->wake.wait(guard, [task]() { return task->value > 0; });
+  else
+    task->wake.wait_for(guard, std::chrono::milliseconds(ticksToWait), [task]() { return task->value > 0; });
+  uint32_t value = task->value;
+  if(value > 0)
+    task->value = clearOnExit ? 0 : value - 1;
+  task->pending = false;
+  return value;
+}
+
+void vTaskDelay(TickType_t ticks) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks * portTICK_PERIOD_MS));
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount) {
+  NativeSemaphore* sem = new NativeSemaphore();
+  sem->count = initialCount;
+  sem->maxCount = maxCount;
+  return sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticksToWait) {
+  std::unique_lock<std::mutex> guard(sem->lock);
+  if(ticksToWait == portMAX_DELAY)
+    sem->wake.wait(guard, [sem]() { return sem->count > 0; });
+  else
+    sem->wake.wait_for(guard, std::chrono::milliseconds(ticksToWait), [sem]() { return sem->count > 0; });
+  if(sem->count == 0)
+    return pdFALSE;
+  sem->count--;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+  std::lock_guard<std::mutex> guard(sem->lock);
+  if(sem->count >= sem->maxCount)
+    return pdFALSE;
+  sem->count++;
+  sem->wake.notify_one();
+  return pdTRUE;
+}
+
+void nativeEnterCritical(portMUX_TYPE* mux) {
+  criticalLock.lock();
+}
+
+void nativeExitCritical(portMUX_TYPE* mux) {
+  criticalLock.unlock();
+}
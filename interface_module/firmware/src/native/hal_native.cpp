@@ -0,0 +1,61 @@
+#include "hal.h"
+#include "websocket.h"
+#include <Arduino.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+static void (*timerHandler)() = nullptr;
+
+// Drives the in-memory GPIO levels; each schedule() starts a sleeper
+// thread that fires unless a later schedule() replaced it
+class NativeRelayPort : public RelayPort {
+public:
+  void write(uint64_t setMask, uint64_t clearMask) override {
+    for(uint8_t pin = 0; pin < NATIVE_GPIOS; pin++) {
+      if(clearMask & (1ULL << pin)) nativeGpioLevel[pin] = LOW;
+      if(setMask & (1ULL << pin)) nativeGpioLevel[pin] = HIGH;
+    }
+  }
+
+  uint64_t nowUs() override {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  void schedule(uint32_t delayUs) override {
+    uint32_t generation = ++generation_;
+    std::thread([this, generation, delayUs]() {
+      std::this_thread::sleep_for(std::chrono::microseconds(delayUs));
+      if(generation == generation_ && timerHandler)
+        timerHandler();
+    }).detach();
+  }
+
+  void lock() override { mutex_.lock(); }
+  void unlock() override { mutex_.unlock(); }
+
+private:
+  std::atomic<uint32_t> generation_{0};
+  std::recursive_mutex mutex_;
+};
+
+RelayPort& halRelayPort() {
+  static NativeRelayPort port;
+  return port;
+}
+
+void halRelayPortBegin(void (*onTimer)()) {
+  timerHandler = onTimer;
+}
+
+// No WebSocket clients on the host
+void sendWebSocketUpdate() {
+}
+
+void sendAntennaNameUpdate() {
+}
+
+void sendOTAStatus(const String& status, const String& message, uint8_t progress) {
+}
@@ -0,0 +1,153 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// Host stand-in for the parts of the Arduino-ESP32 core the control
+// logic uses. Only built in [env:native].
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <limits.h>
+#include <algorithm>
+#include <string>
+#include "freertos_native.h"
+
+using std::min;
+using std::max;
+
+#define LOW     0
+#define HIGH    1
+#define INPUT   0x01
+#define OUTPUT  0x03
+
+#define BUILTIN_LED    2
+#define NATIVE_GPIOS   40
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+// GPIO levels are kept in memory, the relay port writes the same array
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+extern volatile uint8_t nativeGpioLevel[NATIVE_GPIOS];
+
+class String {
+public:
+  String(const char* s = "") : s_(s ? s : "") {}
+  explicit String(const std::string& s) : s_(s) {}
+  explicit String(char c) : s_(1, c) {}
+  explicit String(int v) : s_(std::to_string(v)) {}
+  explicit String(unsigned int v) : s_(std::to_string(v)) {}
+  explicit String(long v) : s_(std::to_string(v)) {}
+  explicit String(unsigned long v) : s_(std::to_string(v)) {}
+
+  const char* c_str() const { return s_.c_str(); }
+  unsigned int length() const { return s_.length(); }
+  bool isEmpty() const { return s_.empty(); }
+  bool reserve(unsigned int size) { s_.reserve(size); return true; }
+
+  char operator[](unsigned int i) const { return i < s_.length() ? s_[i] : 0; }
+  char charAt(unsigned int i) const { return (*this)[i]; }
+
+  bool concat(const char* s) { if(s) s_ += s; return true; }
+  bool concat(const String& s) { s_ += s.s_; return true; }
+  bool concat(char c) { s_ += c; return true; }
+  String& operator+=(const char* s) { concat(s); return *this; }
+  String& operator+=(const String& s) { concat(s); return *this; }
+  String& operator+=(char c) { concat(c); return *this; }
+
+  bool operator==(const String& o) const { return s_ == o.s_; }
+  bool operator==(const char* o) const { return s_ == (o ? o : ""); }
+  bool operator!=(const String& o) const { return s_ != o.s_; }
+  bool operator!=(const char* o) const { return !(*this == o); }
+  bool operator<(const String& o) const { return s_ < o.s_; }
+
+  long toInt() const { return atol(s_.c_str()); }
+  void toLowerCase() { for(auto& c : s_) c = tolower(c); }
+  void toUpperCase() { for(auto& c : s_) c = toupper(c); }
+  void trim();
+  int indexOf(char c, unsigned int from = 0) const;
+  String substring(unsigned int from, unsigned int to = UINT_MAX) const;
+  bool startsWith(const String& prefix) const { return s_.compare(0, prefix.s_.length(), prefix.s_) == 0; }
+
+private:
+  std::string s_;
+};
+
+String operator+(const String& a, const String& b);
+String operator+(const String& a, const char* b);
+String operator+(const char* a, const String& b);
+String operator+(const String& a, char b);
+String operator+(const String& a, int b);
+String operator+(const String& a, unsigned int b);
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size);
+  size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  virtual void flush() {}
+
+  size_t print(const char* s) { return write(s); }
+  size_t print(const String& s) { return write(s.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v) { return printf("%d", v); }
+  size_t print(unsigned int v) { return printf("%u", v); }
+  size_t print(long v) { return printf("%ld", v); }
+  size_t print(unsigned long v) { return printf("%lu", v); }
+  size_t print(double v) { return printf("%.2f", v); }
+
+  size_t println() { return write("\r\n"); }
+  template<typename T> size_t println(const T& v) { size_t n = print(v); return n + println(); }
+
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  size_t readBytes(char* buffer, size_t length);
+  size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+};
+
+// Console stream on stdin/stdout; Serial2 reads nothing and discards output
+class HostSerial : public Stream {
+public:
+  HostSerial(FILE* in, FILE* out) : in_(in), out_(out) {}
+  void begin(unsigned long baud, ...) {}
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+  void flush() override { if(out_) fflush(out_); }
+
+private:
+  FILE* in_;
+  FILE* out_;
+};
+
+extern HostSerial Serial;
+extern HostSerial Serial2;
+
+class EspClass {
+public:
+  uint32_t getCycleCount();
+  uint32_t getFreeHeap() { return 0; }
+  void restart() { exit(0); }
+};
+
+extern EspClass ESP;
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef NATIVE_SPIFFS_H
+#define NATIVE_SPIFFS_H
+
+// SPIFFS on a host directory ($SPIFFS_DIR, default ./spiffs)
+
+#include <Arduino.h>
+#include <memory>
+
+class File : public Stream {
+public:
+  File() {}
+  explicit File(FILE* f) : f_(f, fclose) {}
+
+  explicit operator bool() const { return f_ != nullptr; }
+  void close() { f_.reset(); }
+  size_t size();
+
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+
+private:
+  std::shared_ptr<FILE> f_;
+};
+
+class SPIFFSFS {
+public:
+  bool begin(bool formatOnFail = false);
+  bool exists(const char* path);
+  File open(const char* path, const char* mode = "r");
+  bool remove(const char* path);
+  void end() {}
+};
+
+extern SPIFFSFS SPIFFS;
+
+#endif
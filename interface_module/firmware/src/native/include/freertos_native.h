@@ -0,0 +1,60 @@
+#ifndef FREERTOS_NATIVE_H
+#define FREERTOS_NATIVE_H
+
+// FreeRTOS calls used by the firmware, mapped onto host threads. Each
+// task is a std::thread with one notification value; all critical
+// sections share one recursive mutex.
+
+#include <stdint.h>
+
+typedef struct NativeTask* TaskHandle_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdFALSE  0
+#define pdTRUE   1
+#define pdPASS   1
+#define portMAX_DELAY       0xFFFFFFFFUL
+#define portTICK_PERIOD_MS  1
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+
+enum eNotifyAction {
+  eNoAction = 0,
+  eSetBits,
+  eIncrement,
+  eSetValueWithOverwrite,
+  eSetValueWithoutOverwrite
+};
+
+TaskHandle_t xTaskGetCurrentTaskHandle();
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char* name, uint32_t stackDepth,
+                                   void* param, UBaseType_t priority, TaskHandle_t* created,
+                                   BaseType_t core);
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t* value,
+                           TickType_t ticksToWait);
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait);
+void vTaskDelay(TickType_t ticks);
+
+typedef struct NativeSemaphore* SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticksToWait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+
+typedef struct {
+  uint32_t unused;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {0}
+
+void nativeEnterCritical(portMUX_TYPE* mux);
+void nativeExitCritical(portMUX_TYPE* mux);
+
+#define portENTER_CRITICAL(mux)  nativeEnterCritical(mux)
+#define portEXIT_CRITICAL(mux)   nativeExitCritical(mux)
+
+#endif
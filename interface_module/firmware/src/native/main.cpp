@@ -0,0 +1,74 @@
+// Host simulator: the firmware's control logic on Linux. Reads serial
+// commands (or OTRSP with --otrsp) from stdin and answers on stdout;
+// settings live in $SPIFFS_DIR (default ./spiffs). --bench runs the
+// parser benchmarks instead (bench.cpp), --replay feeds an OTRSP trace
+// captured on the device (replay.cpp).
+//
+//   pio run -e native && echo "set 1 3" | .pio/build/native/program
+//   .pio/build/native/program --bench --out bench.json
+//   .pio/build/native/program --replay otrsp-trace.txt > replies.txt
+
+// pio test links src/ into each test, which brings its own main()
+#ifndef PIO_UNIT_TESTING
+
+#include <Arduino.h>
+#include "globals.h"
+#include "antenna_hardware.h"
+#include "command_parser.h"
+#include "otrsp.h"
+#include "storage.h"
+#include "bench.h"
+#include "replay.h"
+
+// Console input until stdin is exhausted
+static void runConsole(bool otrsp) {
+  char line[OTRSP_BUF_SIZE];
+  uint8_t len = 0;
+  while(Serial.available()) {
+    if(!otrsp) {
+      handleSerialInput(Serial, Serial);
+      continue;
+    }
+
+    // One OTRSP line per pass, so pushes interleave as on the device
+    char c = Serial.read();
+    if(c == '\r') {
+      line[len] = '\0';
+      parseOTRSPCommand(line, Serial);
+      otrspPushChanges();
+      len = 0;
+    } else if(c != '\n' && len < sizeof(line) - 1) {
+      line[len++] = c;
+    }
+    handleStatusLed();
+  }
+}
+
+int main(int argc, char** argv) {
+  bool otrsp = argc > 1 && strcmp(argv[1], "--otrsp") == 0;
+
+  if(!initializeStorage())
+    return 1;
+  initializeHardware();
+  loadSettings();
+
+  if(argc > 1 && strcmp(argv[1], "--bench") == 0)
+    return runBenchmarks(argc, argv);
+
+  if(argc > 1 && strcmp(argv[1], "--replay") == 0) {
+    int result = runReplay(argc, argv);
+    if(result != 0)
+      return result;
+  } else {
+    runConsole(otrsp);
+  }
+
+  // Let a pending make step finish before reporting
+  delay(100);
+  Serial.flush();
+  for(uint8_t r = 0; r < MATRIX_RADIOS; r++)
+    fprintf(stderr, "radio%u=%u ", r + 1, currentAntenna[r]);
+  fprintf(stderr, "\n");
+  return 0;
+}
+#endif
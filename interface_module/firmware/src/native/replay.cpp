@@ -0,0 +1,84 @@
+#include "replay.h"
+#include <Arduino.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "globals.h"
+#include "otrsp.h"
+
+// Replays a trace downloaded from /api/otrsp/trace (otrsp_trace.h format)
+// through parseOTRSPCommand(), as fast as possible or at the recorded
+// pace. Replies go to stdout, so two builds can be diffed on the same
+// trace; the timing summary goes to stderr.
+
+struct ReplayLine {
+  uint64_t us;
+  char text[OTRSP_BUF_SIZE];
+};
+
+static bool loadTrace(const char* path, std::vector<ReplayLine>& lines) {
+  FILE* f = fopen(path, "r");
+  if(!f) {
+    fprintf(stderr, "cannot open %s\n", path);
+    return false;
+  }
+
+  char buffer[128];
+  while(fgets(buffer, sizeof(buffer), f)) {
+    if(buffer[0] == '#')
+      continue;
+    buffer[strcspn(buffer, "\r\n")] = '\0';
+
+    // "<us> <source> <line>", the line may be empty
+    char* end;
+    ReplayLine line;
+    line.us = strtoull(buffer, &end, 10);
+    if(end == buffer || *end != ' ')
+      continue;
+    const char* text = strchr(end + 1, ' ');
+    text = text ? text + 1 : "";
+    strncpy(line.text, text, sizeof(line.text) - 1);
+    line.text[sizeof(line.text) - 1] = '\0';
+    lines.push_back(line);
+  }
+  fclose(f);
+  return true;
+}
+
+int runReplay(int argc, char** argv) {
+  const char* path = nullptr;
+  bool realtime = false;
+
+  for(int i = 1; i < argc; i++) {
+    if(strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+      path = argv[++i];
+    else if(strcmp(argv[i], "--realtime") == 0)
+      realtime = true;
+  }
+  if(!path) {
+    fprintf(stderr, "usage: --replay FILE [--realtime]\n");
+    return 2;
+  }
+
+  std::vector<ReplayLine> lines;
+  if(!loadTrace(path, lines))
+    return 1;
+
+  auto start = std::chrono::steady_clock::now();
+  for(const ReplayLine& line : lines) {
+    if(realtime)
+      std::this_thread::sleep_until(start + std::chrono::microseconds(line.us));
+    parseOTRSPCommand(line.text, Serial);
+    otrspPushChanges();
+  }
+  uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - start).count();
+
+  Serial.flush();
+  fprintf(stderr, "%zu lines in %.3f ms, %.1f ns/line", lines.size(), ns / 1e6,
+          lines.empty() ? 0.0 : (double)ns / lines.size());
+  if(realtime && !lines.empty())
+    fprintf(stderr, " (trace span %.3f ms)", lines.back().us / 1e3);
+  fprintf(stderr, "\n");
+  return 0;
+}
@@ -0,0 +1,10 @@
+#ifndef NATIVE_REPLAY_H
+#define NATIVE_REPLAY_H
+
+/**
+ * @brief Feed an OTRSP trace file into the parser (simulator --replay)
+ * @return Process exit code
+ */
+int runReplay(int argc, char** argv);
+
+#endif
@@ -0,0 +1,70 @@
+#include <SPIFFS.h>
+#include <sys/stat.h>
+
+SPIFFSFS SPIFFS;
+
+static std::string hostPath(const char* path) {
+  const char* root = getenv("SPIFFS_DIR");
+  return std::string(root ? root : "spiffs") + path;
+}
+
+bool SPIFFSFS::begin(bool formatOnFail) {
+  struct stat st;
+  std::string root = hostPath("");
+  if(stat(root.c_str(), &st) == 0)
+    return S_ISDIR(st.st_mode);
+  return formatOnFail && mkdir(root.c_str(), 0755) == 0;
+}
+
+bool SPIFFSFS::exists(const char* path) {
+  struct stat st;
+  return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+File SPIFFSFS::open(const char* path, const char* mode) {
+  std::string fopenMode = std::string(mode) + "b";
+  FILE* f = fopen(hostPath(path).c_str(), fopenMode.c_str());
+  return f ? File(f) : File();
+}
+
+bool SPIFFSFS::remove(const char* path) {
+  return ::remove(hostPath(path).c_str()) == 0;
+}
+
+size_t File::size() {
+  if(!f_)
+    return 0;
+  long pos = ftell(f_.get());
+  fseek(f_.get(), 0, SEEK_END);
+  long end = ftell(f_.get());
+  fseek(f_.get(), pos, SEEK_SET);
+  return end;
+}
+
+int File::available() {
+  if(!f_)
+    return 0;
+  long pos = ftell(f_.get());
+  return pos < 0 ? 0 : (int)(size() - pos);
+}
+
+int File::read() {
+  return f_ ? getc(f_.get()) : -1;
+}
+
+int File::peek() {
+  if(!f_)
+    return -1;
+  int c = getc(f_.get());
+  if(c != EOF)
+    ungetc(c, f_.get());
+  return c == EOF ? -1 : c;
+}
+
+size_t File::write(uint8_t c) {
+  return f_ && fputc(c, f_.get()) != EOF ? 1 : 0;
+}
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+  return f_ ? fwrite(buffer, 1, size, f_.get()) : 0;
+}
@@ -1,203 +1,270 @@
 #include "otrsp.h"
 #include "globals.h"
 #include "antenna_hardware.h"
+#include "latency_stats.h"
+#include "band_index.h"
+#include "otrsp_trace.h"
 
-OTRSPState otrspState = {1, "1", {"0", "0"}, {'0', '0'}, false};
+OTRSPState otrspState = {1, "1", {"0", "0"}, {'0', '0'}, 0};
 
-static WiFiServer otrspServer(OTRSP_TCP_PORT);
-static WiFiClient otrspClient;
-static char tcpBuffer[OTRSP_BUF_SIZE];
-static uint8_t tcpBufLen = 0;
 static char serialBuffer[OTRSP_BUF_SIZE];
 static uint8_t serialBufLen = 0;
+static uint32_t serialLineStart = 0;
 
-// Forward declarations
-static bool startsWith(const char* str, const char* prefix);
-static int prefixLen(const char* str, const char* prefix);
+// AUX ports are single digits
+#define OTRSP_AUX_PORTS min(MATRIX_RADIOS, 9)
 
-static bool startsWith(const char* str, const char* prefix) {
-    return strncmp(str, prefix, strlen(prefix)) == 0;
-}
+// Streams that asked for unsolicited state lines (SUB1), one per TCP
+// client plus UART2
+#define OTRSP_SUBSCRIBERS (OTRSP_MAX_CLIENTS + 1)
+static Stream* subscribers[OTRSP_SUBSCRIBERS];
+
+// State as last seen by otrspPushChanges()
+static uint8_t pushedAntenna[MATRIX_RADIOS];
+static uint8_t pushedTxFocus = 1;
+static char pushedRxFocus[OTRSP_RX_SIZE] = "1";
 
-static int prefixLen(const char* str, const char* prefix) {
-    size_t len = strlen(prefix);
-    if (strncmp(str, prefix, len) == 0) return len;
-    return 0;
+// Copy a reported value into a fixed state field, truncating if needed
+static void copyField(char* dst, size_t size, const char* src) {
+    size_t len = strnlen(src, size - 1);
+    memcpy(dst, src, len);
+    dst[len] = '\0';
 }
 
-void parseOTRSPCommand(const char* cmd, Stream& response) {
-    if (cmd[0] == '\0') return;
+// Batch extension: "AUX13,24" sets port 1 to 3 and port 2 to 4 as one
+// switch. A batch with any malformed item ("AUX13x,24", "AUX1-,2") is
+// ignored as a whole, like other bad set commands.
+static void setAuxBatch(const char* items) {
+    AntennaSelection selections[MATRIX_RADIOS];
+    uint8_t count = 0;
 
-    bool isQuery = (cmd[0] == '?');
-    const char* body = isQuery ? cmd + 1 : cmd;
+    const char* item = items;
+    for (;;) {
+        // strtoul() would also take spaces and a sign
+        if (count == MATRIX_RADIOS ||
+            item[0] < '1' || item[0] >= '1' + OTRSP_AUX_PORTS ||
+            item[1] < '0' || item[1] > '9') {
+            return;
+        }
+        char* end;
+        unsigned long val = strtoul(item + 1, &end, 10);
+        if ((*end != ',' && *end != '\0') || val > MATRIX_ANTENNAS) return;
+        selections[count].radio = item[0] - '1';
+        selections[count].antenna = val;
+        count++;
+        if (*end == '\0') break;
+        item = end + 1;
+    }
+    selectAntennas(selections, count);
+}
 
-    // Ping: just "?" with nothing after
-    if (isQuery && body[0] == '\0') {
-        response.print("?\r");
-        return;
+// Command handlers get the text after the command name
+
+static void handleTX(const char* rest, bool isQuery, Stream& response) {
+    if (isQuery) {
+        response.printf("TX%u\r", otrspState.txFocus);
+    } else if (rest[0] == '1' || rest[0] == '2') {
+        otrspState.txFocus = rest[0] - '0';
     }
+}
 
-    int plen;
+static void handleRX(const char* rest, bool isQuery, Stream& response) {
+    if (isQuery) {
+        response.printf("RX%s\r", otrspState.rxFocus);
+    } else if (rest[0] != '\0') {
+        copyField(otrspState.rxFocus, sizeof(otrspState.rxFocus), rest);
+    }
+}
 
-    // TX command
-    if ((plen = prefixLen(body, "TX")) > 0) {
-        const char* rest = body + plen;
+static void handleAUX(const char* rest, bool isQuery, Stream& response) {
+    // Item is the port number (1 to MATRIX_RADIOS)
+    if (rest[0] >= '1' && rest[0] < '1' + OTRSP_AUX_PORTS) {
+        uint8_t radio = rest[0] - '1';
+        const char* valStr = rest + 1;
         if (isQuery) {
-            response.printf("TX%u\r", otrspState.txFocus);
-        } else if (rest[0] == '1' || rest[0] == '2') {
-            otrspState.txFocus = rest[0] - '0';
+            response.printf("AUX%u%u\r", radio + 1, currentAntenna[radio]);
+        } else if (strchr(valStr, ',')) {
+            setAuxBatch(rest);
+        } else if (valStr[0] != '\0') {
+            int val = atoi(valStr);
+            if (val >= 0 && val <= MATRIX_ANTENNAS) {
+                selectAntenna(radio, val);
+            }
         }
-        return;
+    } else if (isQuery) {
+        // Unknown AUX port - echo back
+        response.printf("?AUX%s\r", rest);
     }
+}
 
-    // RX command
-    if ((plen = prefixLen(body, "RX")) > 0) {
-        const char* rest = body + plen;
+static void handleBAND(const char* rest, bool isQuery, Stream& response) {
+    if (rest[0] == '1' || rest[0] == '2') {
+        uint8_t radio = rest[0] - '1';
         if (isQuery) {
-            response.printf("RX%s\r", otrspState.rxFocus.c_str());
-        } else if (rest[0] != '\0') {
-            otrspState.rxFocus = String(rest);
+            response.printf("BAND%u%s\r", radio + 1, otrspState.band[radio]);
+        } else if (rest[1] != '\0') {
+            copyField(otrspState.band[radio], sizeof(otrspState.band[radio]), rest + 1);
+            if (bandAutoSelect) {
+                selectAntennaForBand(radio, bandFromReport(rest + 1));
+            }
         }
-        return;
     }
+}
 
-    // AUX command
-    if ((plen = prefixLen(body, "AUX")) > 0) {
-        const char* rest = body + plen;
-        // Item is the port number (1 or 2)
-        if (rest[0] >= '1' && rest[0] <= '2') {
-            uint8_t radio = rest[0] - '1'; // 0 or 1
-            const char* valStr = rest + 1;
-            if (isQuery) {
-                response.printf("AUX%u%u\r", radio + 1, currentAntenna[radio]);
-            } else if (valStr[0] != '\0') {
-                int val = atoi(valStr);
-                if (val >= 0 && val <= 6) {
-                    selectAntenna(radio, val);
-                }
-            }
-        } else if (isQuery) {
-            // Unknown AUX port - echo back
-            response.printf("?AUX%s\r", rest);
+static void handleMODE(const char* rest, bool isQuery, Stream& response) {
+    if (rest[0] == '1' || rest[0] == '2') {
+        uint8_t radio = rest[0] - '1';
+        if (isQuery) {
+            response.printf("MODE%u%c\r", radio + 1, otrspState.mode[radio]);
+        } else if (rest[1] != '\0') {
+            otrspState.mode[radio] = rest[1];
         }
-        return;
     }
+}
 
-    // BAND command
-    if ((plen = prefixLen(body, "BAND")) > 0) {
-        const char* rest = body + plen;
-        if (rest[0] == '1' || rest[0] == '2') {
-            uint8_t radio = rest[0] - '1';
-            if (isQuery) {
-                response.printf("BAND%u%s\r", radio + 1, otrspState.band[radio].c_str());
-            } else if (rest[1] != '\0') {
-                otrspState.band[radio] = String(rest + 1);
-            }
-        }
-        return;
+static void handleNAME(const char* rest, bool isQuery, Stream& response) {
+    if (isQuery) {
+        response.print("NAME" DEVICE_NAME "\r");
+    }
+    // Set NAME is ignored per spec
+}
+
+static bool isSubscribed(Stream& stream) {
+    for (uint8_t i = 0; i < OTRSP_SUBSCRIBERS; i++) {
+        if (subscribers[i] == &stream) return true;
     }
+    return false;
+}
 
-    // MODE command
-    if ((plen = prefixLen(body, "MODE")) > 0) {
-        const char* rest = body + plen;
-        if (rest[0] == '1' || rest[0] == '2') {
-            uint8_t radio = rest[0] - '1';
-            if (isQuery) {
-                response.printf("MODE%u%c\r", radio + 1, otrspState.mode[radio]);
-            } else if (rest[1] != '\0') {
-                otrspState.mode[radio] = rest[1];
+// Current AUX, TX and RX lines, sent to a new subscriber
+static void printState(Stream& stream) {
+    for (uint8_t radio = 0; radio < OTRSP_AUX_PORTS; radio++) {
+        stream.printf("AUX%u%u\r", radio + 1, currentAntenna[radio]);
+    }
+    stream.printf("TX%u\r", otrspState.txFocus);
+    stream.printf("RX%s\r", otrspState.rxFocus);
+}
+
+// Subscription extension: "SUB1" pushes state changes to this
+// connection, "SUB0" stops it
+static void handleSUB(const char* rest, bool isQuery, Stream& response) {
+    if (isQuery) {
+        response.printf("SUB%u\r", isSubscribed(response) ? 1 : 0);
+    } else if (rest[0] == '1' && !isSubscribed(response)) {
+        for (uint8_t i = 0; i < OTRSP_SUBSCRIBERS; i++) {
+            if (!subscribers[i]) {
+                subscribers[i] = &response;
+                printState(response);
+                break;
             }
         }
-        return;
+    } else if (rest[0] == '0') {
+        otrspUnsubscribe(response);
     }
+}
 
-    // NAME command
-    if ((plen = prefixLen(body, "NAME")) > 0) {
-        if (isQuery) {
-            response.printf("NAME6x2 Antenna Switch SQ9NJE\r");
-        }
-        // Set NAME is ignored per spec
+static void handleFW(const char* rest, bool isQuery, Stream& response) {
+    if (isQuery) {
+        response.print("FW1.0.0\r");
+    }
+    // Set FW is ignored per spec
+}
+
+struct OTRSPCommand {
+    const char* name;
+    uint8_t len;
+    void (*handler)(const char* rest, bool isQuery, Stream& response);
+};
+
+static const OTRSPCommand cmdAUX  = {"AUX",  3, handleAUX};
+static const OTRSPCommand cmdBAND = {"BAND", 4, handleBAND};
+static const OTRSPCommand cmdFW   = {"FW",   2, handleFW};
+static const OTRSPCommand cmdMODE = {"MODE", 4, handleMODE};
+static const OTRSPCommand cmdNAME = {"NAME", 4, handleNAME};
+static const OTRSPCommand cmdRX   = {"RX",   2, handleRX};
+static const OTRSPCommand cmdSUB  = {"SUB",  3, handleSUB};
+static const OTRSPCommand cmdTX   = {"TX",   2, handleTX};
+
+// Indexed by first letter; no two OTRSP commands share one
+static const OTRSPCommand* const commandTable[26] = {
+    &cmdAUX,  &cmdBAND, nullptr,  nullptr,  nullptr,  &cmdFW,    // A-F
+    nullptr,  nullptr,  nullptr,  nullptr,  nullptr,  nullptr,   // G-L
+    &cmdMODE, &cmdNAME, nullptr,  nullptr,  nullptr,  &cmdRX,    // M-R
+    &cmdSUB,  &cmdTX,   nullptr,  nullptr,  nullptr,  nullptr,   // S-X
+    nullptr,  nullptr                                            // Y-Z
+};
+
+void parseOTRSPCommand(const char* cmd, Stream& response) {
+    if (cmd[0] == '\0') return;
+
+    bool isQuery = (cmd[0] == '?');
+    const char* body = isQuery ? cmd + 1 : cmd;
+
+    // Ping: just "?" with nothing after
+    if (isQuery && body[0] == '\0') {
+        response.print("?\r");
         return;
     }
 
-    // FW command
-    if ((plen = prefixLen(body, "FW")) > 0) {
-        if (isQuery) {
-            response.print("FW1.0.0\r");
+    const OTRSPCommand* command = nullptr;
+    if (body[0] >= 'A' && body[0] <= 'Z') {
+        command = commandTable[body[0] - 'A'];
+        if (command && strncmp(body + 1, command->name + 1, command->len - 1) != 0) {
+            command = nullptr;
         }
-        // Set FW is ignored per spec
-        return;
     }
 
-    // Unknown command
-    if (isQuery) {
+    if (command) {
+        command->handler(body + command->len, isQuery, response);
+    } else if (isQuery) {
         // Echo back unknown query
         response.printf("?%s\r", body);
     }
     // Unknown non-query commands are silently ignored per spec
 }
 
-void initializeOTRSP() {
-    if (otrspEnabled) {
-        otrspServer.begin();
-        if (otrspServer) {
-            Serial.printf("OTRSP TCP server listening on port %d\n", OTRSP_TCP_PORT);
-        } else {
-            Serial.printf("OTRSP TCP server FAILED to start on port %d\n", OTRSP_TCP_PORT);
-        }
-    } else {
-        Serial.println("OTRSP TCP server disabled");
-    }
-}
-
-void handleOTRSPLoop() {
-    if (!otrspEnabled) return;
-
-    // Accept new client
-    if (otrspServer.hasClient()) {
-        WiFiClient newClient = otrspServer.available();
-        if (newClient) {
-            if (otrspClient && otrspClient.connected()) {
-                // Reject if already have a client
-                newClient.stop();
-            } else {
-                otrspClient = newClient;
-                otrspState.clientConnected = true;
-                tcpBufLen = 0;
-                Serial.println("OTRSP client connected");
-            }
-        }
+void otrspUnsubscribe(Stream& stream) {
+    for (uint8_t i = 0; i < OTRSP_SUBSCRIBERS; i++) {
+        if (subscribers[i] == &stream) subscribers[i] = nullptr;
     }
+}
 
-    // Handle connected client
-    if (otrspClient && otrspClient.connected()) {
-        while (otrspClient.available()) {
-            char c = otrspClient.read();
-            if (c == '\r') {
-                tcpBuffer[tcpBufLen] = '\0';
-                parseOTRSPCommand(tcpBuffer, otrspClient);
-                tcpBufLen = 0;
-            } else if (c != '\n' && tcpBufLen < OTRSP_BUF_SIZE - 1) {
-                tcpBuffer[tcpBufLen++] = c;
-            }
+void otrspPushChanges() {
+    // Lines for everything that changed since the last call, whoever changed it
+    char lines[OTRSP_AUX_PORTS * 6 + 24];
+    size_t len = 0;
+
+    for (uint8_t radio = 0; radio < OTRSP_AUX_PORTS; radio++) {
+        if (currentAntenna[radio] != pushedAntenna[radio]) {
+            pushedAntenna[radio] = currentAntenna[radio];
+            len += snprintf(lines + len, sizeof(lines) - len, "AUX%u%u\r", radio + 1, pushedAntenna[radio]);
         }
-    } else if (otrspState.clientConnected) {
-        otrspState.clientConnected = false;
-        Serial.println("OTRSP client disconnected");
     }
+    if (otrspState.txFocus != pushedTxFocus) {
+        pushedTxFocus = otrspState.txFocus;
+        len += snprintf(lines + len, sizeof(lines) - len, "TX%u\r", pushedTxFocus);
+    }
+    if (strcmp(otrspState.rxFocus, pushedRxFocus) != 0) {
+        memcpy(pushedRxFocus, otrspState.rxFocus, sizeof(pushedRxFocus));
+        len += snprintf(lines + len, sizeof(lines) - len, "RX%s\r", pushedRxFocus);
+    }
+    if (len == 0) return;
 
-    // Handle OTRSP on UART2 if enabled
-    if (otrspSerialEnabled) {
-        handleOTRSPSerialInput(Serial2);
+    for (uint8_t i = 0; i < OTRSP_SUBSCRIBERS; i++) {
+        if (subscribers[i]) subscribers[i]->write((const uint8_t*)lines, len);
     }
 }
 
 void handleOTRSPSerialInput(Stream& serial) {
     while (serial.available()) {
+        if (serialBufLen == 0) serialLineStart = micros();
         char c = serial.read();
         if (c == '\r') {
             serialBuffer[serialBufLen] = '\0';
+            otrspTraceRecord(OTRSP_TRACE_UART2, serialBuffer);
+            latencyBegin(LATENCY_UART2, serialLineStart);
             parseOTRSPCommand(serialBuffer, serial);
+            latencyEnd();
             serialBufLen = 0;
         } else if (c != '\n' && serialBufLen < OTRSP_BUF_SIZE - 1) {
             serialBuffer[serialBufLen++] = c;
@@ -0,0 +1,289 @@
+#include "otrsp.h"
+#include "globals.h"
+#include "latency_stats.h"
+#include "otrsp_trace.h"
+#include <AsyncTCP.h>
+#include <lwip/tcp.h>
+
+// Keepalive probing of idle clients, so a logger that vanished without
+// closing frees its slot after about 25 s
+#define OTRSP_KEEPALIVE_IDLE_S      10
+#define OTRSP_KEEPALIVE_INTERVAL_S  5
+#define OTRSP_KEEPALIVE_COUNT       3
+
+// Collects the replies to one received packet, sent as one TCP write.
+// Bytes TCP has no room for stay queued and are retried on the next ack
+// or loop pass; a client that lets the queue fill up is closed instead
+// of losing lines.
+class OTRSPReply : public Stream {
+public:
+    OTRSPReply() : client_(nullptr), len_(0), overflowed_(false) {}
+
+    void attach(AsyncClient* client) {
+        client_ = client;
+        len_ = 0;
+        overflowed_ = false;
+    }
+
+    size_t write(uint8_t c) override {
+        return write(&c, 1);
+    }
+
+    size_t write(const uint8_t* data, size_t size) override {
+        if (overflowed_) return 0;
+        if (len_ + size > sizeof(data_)) send();
+        size_t sent = 0;
+        if (len_ == 0 && size > sizeof(data_)) sent = writeSome(data, size);
+        if (len_ + size - sent > sizeof(data_)) {
+            overflowed_ = true;
+            return sent;
+        }
+        memcpy(data_ + len_, data + sent, size - sent);
+        len_ += size - sent;
+        return size;
+    }
+
+    void send() {
+        size_t sent = writeSome(data_, len_);
+        memmove(data_, data_ + sent, len_ - sent);
+        len_ -= sent;
+    }
+
+    // Set once bytes had to be dropped; the client must then be closed
+    bool overflowed() const { return overflowed_; }
+
+    // Replies only; input arrives through the onData callback
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+
+private:
+    // As many bytes as the TCP send buffer takes now
+    size_t writeSome(const uint8_t* data, size_t size) {
+        size_t room = client_->space();
+        if (size > room) size = room;
+        if (size == 0) return 0;
+        return client_->write((const char*)data, size);
+    }
+
+    AsyncClient* client_;
+    uint8_t data_[OTRSP_REPLY_SIZE];
+    size_t len_;
+    bool overflowed_;
+};
+
+// One connected logger, bridge or script
+struct OTRSPClientSlot {
+    AsyncClient* client;
+    OTRSPReply reply;   // also the stream subscriptions push to
+    bool active;
+    char buffer[OTRSP_BUF_SIZE];
+    uint8_t len;
+    uint32_t connectedAt;
+    uint32_t lines;
+    uint32_t serviceUs;
+};
+
+// Time spent handling received packets
+struct OTRSPPacketStats {
+    uint64_t totalUs;
+    uint32_t packets;
+};
+
+static AsyncServer otrspServer(OTRSP_TCP_PORT);
+static OTRSPClientSlot clients[OTRSP_MAX_CLIENTS];
+static OTRSPPacketStats packetStats;
+
+// TCP callbacks run on the AsyncTCP task, UART2 and pushes on the loop
+// task; the lock keeps OTRSP state and subscriptions consistent between them
+static SemaphoreHandle_t otrspMutex = nullptr;
+
+// Changed AUX/TX/RX lines to subscribers, then every client's queued
+// bytes to TCP. Caller holds otrspMutex.
+static void pushAndSend() {
+    otrspPushChanges();
+    for (uint8_t slot = 0; slot < OTRSP_MAX_CLIENTS; slot++) {
+        if (clients[slot].active) clients[slot].reply.send();
+    }
+}
+
+// Idle peers are probed; replies go out immediately as the server
+// disables Nagle on accepted clients
+static void enableKeepalive(AsyncClient* client) {
+    tcp_pcb* pcb = client->getPCB();
+    if (!pcb) return;
+    ip_set_option(pcb, SOF_KEEPALIVE);
+    pcb->keep_idle = OTRSP_KEEPALIVE_IDLE_S * 1000UL;
+    pcb->keep_intvl = OTRSP_KEEPALIVE_INTERVAL_S * 1000UL;
+    pcb->keep_cnt = OTRSP_KEEPALIVE_COUNT;
+}
+
+// Parse every complete line in the packet, partial lines wait in the
+// slot buffer for the next one
+static void onClientData(void* arg, AsyncClient* client, void* data, size_t len) {
+    OTRSPClientSlot& c = *(OTRSPClientSlot*)arg;
+    uint32_t start = micros();
+    const char* bytes = (const char*)data;
+    if (!otrspEnabled) return;
+
+    xSemaphoreTake(otrspMutex, portMAX_DELAY);
+    for (size_t i = 0; i < len; i++) {
+        char ch = bytes[i];
+        if (ch == '\r') {
+            c.buffer[c.len] = '\0';
+            otrspTraceRecord(&c - clients + 1, c.buffer);
+            latencyBegin(LATENCY_OTRSP_TCP, start);
+            parseOTRSPCommand(c.buffer, c.reply);
+            latencyEnd();
+            c.len = 0;
+            c.lines++;
+        } else if (ch != '\n' && c.len < OTRSP_BUF_SIZE - 1) {
+            c.buffer[c.len++] = ch;
+        }
+    }
+    // Other subscribers hear about this client's switches now, not on
+    // the next loop pass
+    pushAndSend();
+
+    uint32_t us = micros() - start;
+    c.serviceUs += us;
+    packetStats.totalUs += us;
+    packetStats.packets++;
+    xSemaphoreGive(otrspMutex);
+}
+
+// TCP freed send buffer space: retry what is still queued
+static void onClientAck(void* arg, AsyncClient* client, size_t len, uint32_t time) {
+    OTRSPClientSlot& c = *(OTRSPClientSlot*)arg;
+
+    xSemaphoreTake(otrspMutex, portMAX_DELAY);
+    c.reply.send();
+    xSemaphoreGive(otrspMutex);
+}
+
+// Runs about twice a second. A client whose replies overflowed is closed
+// here, outside the lock (onClientDisconnect takes it) and not from
+// inside onData, which still uses the client after its callback.
+static void onClientPoll(void* arg, AsyncClient* client) {
+    OTRSPClientSlot& c = *(OTRSPClientSlot*)arg;
+
+    xSemaphoreTake(otrspMutex, portMAX_DELAY);
+    bool overflowed = c.reply.overflowed();
+    xSemaphoreGive(otrspMutex);
+
+    if (overflowed) {
+        Serial.printf("OTRSP client %u not reading its replies, closed\n", (unsigned)(&c - clients) + 1);
+        client->close(true);
+    }
+}
+
+static void onClientDisconnect(void* arg, AsyncClient* client) {
+    OTRSPClientSlot& c = *(OTRSPClientSlot*)arg;
+
+    xSemaphoreTake(otrspMutex, portMAX_DELAY);
+    otrspUnsubscribe(c.reply);
+    c.active = false;
+    c.client = nullptr;
+    otrspState.clients--;
+    xSemaphoreGive(otrspMutex);
+
+    Serial.printf("OTRSP client %u disconnected\n", (unsigned)(&c - clients) + 1);
+    delete client;
+}
+
+static void onClientConnect(void* arg, AsyncClient* client) {
+    xSemaphoreTake(otrspMutex, portMAX_DELAY);
+    uint8_t slot = 0;
+    while (slot < OTRSP_MAX_CLIENTS && clients[slot].active) slot++;
+    if (!otrspEnabled || slot == OTRSP_MAX_CLIENTS) {
+        xSemaphoreGive(otrspMutex);
+        Serial.println(otrspEnabled ? "OTRSP client rejected, all slots in use"
+                                    : "OTRSP client rejected, TCP disabled");
+        client->close(true);
+        delete client;
+        return;
+    }
+
+    OTRSPClientSlot& c = clients[slot];
+    c.client = client;
+    c.reply.attach(client);
+    c.active = true;
+    c.len = 0;
+    c.connectedAt = millis();
+    c.lines = 0;
+    c.serviceUs = 0;
+    otrspState.clients++;
+    xSemaphoreGive(otrspMutex);
+
+    enableKeepalive(client);
+    client->onData(onClientData, &c);
+    client->onAck(onClientAck, &c);
+    client->onPoll(onClientPoll, &c);
+    client->onDisconnect(onClientDisconnect, &c);
+    Serial.printf("OTRSP client %u connected from %s\n", slot + 1,
+                  client->remoteIP().toString().c_str());
+}
+
+void initializeOTRSP() {
+    otrspMutex = xSemaphoreCreateMutex();
+
+    if (otrspEnabled) {
+        otrspServer.setNoDelay(true);
+        otrspServer.onClient(onClientConnect, nullptr);
+        otrspServer.begin();
+        Serial.printf("OTRSP TCP server listening on port %d\n", OTRSP_TCP_PORT);
+    } else {
+        Serial.println("OTRSP TCP server disabled");
+    }
+}
+
+void handleOTRSPLoop() {
+    xSemaphoreTake(otrspMutex, portMAX_DELAY);
+
+    // Handle OTRSP on UART2 if enabled
+    if (otrspSerialEnabled) {
+        handleOTRSPSerialInput(Serial2);
+    } else {
+        otrspUnsubscribe(Serial2);
+    }
+
+    // Switches from any source not pushed yet, e.g. UART2
+    pushAndSend();
+
+    xSemaphoreGive(otrspMutex);
+}
+
+void otrspPushNow() {
+    // Before initializeOTRSP() there is nothing to push to
+    if (!otrspMutex) return;
+
+    xSemaphoreTake(otrspMutex, portMAX_DELAY);
+    pushAndSend();
+    xSemaphoreGive(otrspMutex);
+}
+
+bool otrspClientInfo(uint8_t slot, OTRSPClientInfo* info) {
+    if (slot >= OTRSP_MAX_CLIENTS) return false;
+
+    xSemaphoreTake(otrspMutex, portMAX_DELAY);
+    OTRSPClientSlot& c = clients[slot];
+    bool active = c.active;
+    if (active) {
+        info->ip = (uint32_t)c.client->remoteIP();
+        info->port = c.client->remotePort();
+        info->connectedMs = millis() - c.connectedAt;
+        info->lines = c.lines;
+        info->serviceUs = c.serviceUs;
+    }
+    xSemaphoreGive(otrspMutex);
+    return active;
+}
+
+uint32_t otrspPacketUs() {
+    if (packetStats.packets == 0) return 0;
+    return (uint32_t)(packetStats.totalUs / packetStats.packets);
+}
+
+size_t otrspClientBytes() {
+    return sizeof(OTRSPClientSlot) + sizeof(AsyncClient);
+}
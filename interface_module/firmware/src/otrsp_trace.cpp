@@ -0,0 +1,145 @@
+#include "otrsp_trace.h"
+#include "otrsp.h"
+
+// Records are packed back to back in a byte ring:
+// [micros() u32][source u8][length u8][line bytes]
+#define TRACE_HEADER 6
+
+static uint8_t* ring = nullptr;
+static volatile bool active = false;
+static uint32_t head = 0;       // write offset
+static uint32_t tail = 0;       // offset of the oldest record
+static uint32_t used = 0;
+static uint32_t firstSeq = 0;   // sequence number of the oldest record
+static uint32_t nextSeq = 0;
+static uint32_t overwritten = 0;
+static portMUX_TYPE traceMux = portMUX_INITIALIZER_UNLOCKED;
+
+static void ringPut(uint32_t offset, const void* data, uint32_t len) {
+    const uint8_t* src = (const uint8_t*)data;
+    for (uint32_t i = 0; i < len; i++) ring[(offset + i) % OTRSP_TRACE_BYTES] = src[i];
+}
+
+static void ringGet(uint32_t offset, void* data, uint32_t len) {
+    uint8_t* dst = (uint8_t*)data;
+    for (uint32_t i = 0; i < len; i++) dst[i] = ring[(offset + i) % OTRSP_TRACE_BYTES];
+}
+
+static uint32_t recordSize(uint32_t offset) {
+    return TRACE_HEADER + ring[(offset + 5) % OTRSP_TRACE_BYTES];
+}
+
+bool otrspTraceStart() {
+    if (!ring) ring = (uint8_t*)malloc(OTRSP_TRACE_BYTES);
+    if (!ring) return false;
+
+    portENTER_CRITICAL(&traceMux);
+    head = tail = used = 0;
+    firstSeq = nextSeq = 0;
+    overwritten = 0;
+    active = true;
+    portEXIT_CRITICAL(&traceMux);
+    return true;
+}
+
+void otrspTraceStop() {
+    active = false;
+}
+
+void otrspTraceRecord(uint8_t source, const char* line) {
+    if (!active) return;
+
+    uint32_t now = micros();
+    uint8_t len = strnlen(line, OTRSP_BUF_SIZE - 1);
+    uint32_t size = TRACE_HEADER + len;
+
+    portENTER_CRITICAL(&traceMux);
+    while (OTRSP_TRACE_BYTES - used < size) {
+        uint32_t oldest = recordSize(tail);
+        tail = (tail + oldest) % OTRSP_TRACE_BYTES;
+        used -= oldest;
+        firstSeq++;
+        overwritten++;
+    }
+    ringPut(head, &now, 4);
+    ringPut(head + 4, &source, 1);
+    ringPut(head + 5, &len, 1);
+    ringPut(head + TRACE_HEADER, line, len);
+    head = (head + size) % OTRSP_TRACE_BYTES;
+    used += size;
+    nextSeq++;
+    portEXIT_CRITICAL(&traceMux);
+}
+
+OTRSPTraceStatus otrspTraceStatus() {
+    OTRSPTraceStatus status;
+    portENTER_CRITICAL(&traceMux);
+    status.active = active;
+    status.records = nextSeq - firstSeq;
+    status.overwritten = overwritten;
+    status.bytes = OTRSP_TRACE_BYTES;
+    portEXIT_CRITICAL(&traceMux);
+    return status;
+}
+
+// snprintf() result as the length actually stored
+static size_t clampLength(int len, size_t size) {
+    return len < (int)size ? len : size - 1;
+}
+
+void otrspTraceRewind(OTRSPTraceCursor& cursor) {
+    cursor.seq = 0;
+    cursor.offset = 0;
+    cursor.prevUs = 0;
+    cursor.elapsedUs = 0;
+    cursor.header = false;
+    cursor.started = false;
+}
+
+size_t otrspTraceNextLine(OTRSPTraceCursor& cursor, char* text, size_t size) {
+    if (!cursor.header) {
+        cursor.header = true;
+        return clampLength(snprintf(text, size, "# OTRSP trace: us since first line, source (U2 = UART2, T1-T4 = TCP client), line\n"), size);
+    }
+    if (!ring) return 0;
+
+    // Copy one record at a time, so capture can go on while downloading;
+    // records overwritten meanwhile are skipped
+    uint32_t us;
+    uint8_t source;
+    uint8_t len;
+    char line[OTRSP_BUF_SIZE];
+
+    portENTER_CRITICAL(&traceMux);
+    if (!cursor.started || cursor.seq < firstSeq) {
+        cursor.seq = firstSeq;
+        cursor.offset = tail;
+    }
+    bool more = cursor.seq != nextSeq;
+    if (more) {
+        ringGet(cursor.offset, &us, 4);
+        ringGet(cursor.offset + 4, &source, 1);
+        ringGet(cursor.offset + 5, &len, 1);
+        ringGet(cursor.offset + TRACE_HEADER, line, len);
+        cursor.offset = (cursor.offset + TRACE_HEADER + len) % OTRSP_TRACE_BYTES;
+        cursor.seq++;
+    }
+    portEXIT_CRITICAL(&traceMux);
+    if (!more) return 0;
+
+    line[len] = '\0';
+    if (!cursor.started) {
+        cursor.prevUs = us;
+        cursor.started = true;
+    }
+    cursor.elapsedUs += (uint32_t)(us - cursor.prevUs);
+    cursor.prevUs = us;
+
+    char sourceName[5];
+    if (source == OTRSP_TRACE_UART2) {
+        strcpy(sourceName, "U2");
+    } else {
+        snprintf(sourceName, sizeof(sourceName), "T%u", source);
+    }
+    return clampLength(snprintf(text, size, "%llu %s %s\n", (unsigned long long)cursor.elapsedUs, sourceName, line), size);
+}
@@ -1,8 +1,35 @@
 #include "storage.h"
 #include "globals.h"
+#include "antenna_hardware.h"
+#include "band_index.h"
+#include "uart2.h"
 #include <SPIFFS.h>
 #include <ArduinoJson.h>
 
+// Every settings member but the antennas: the scalar settings and the
+// relaySettleMs table
+#define SETTINGS_JSON_FIXED_SIZE (JSON_OBJECT_SIZE(12) + JSON_ARRAY_SIZE(MATRIX_RADIOS) + \
+                                  MATRIX_RADIOS * JSON_ARRAY_SIZE(MATRIX_ANTENNAS))
+
+size_t antennasJsonCapacity() {
+  size_t capacity = JSON_ARRAY_SIZE(MATRIX_ANTENNAS);
+  for(int i = 0; i < MATRIX_ANTENNAS; i++) {
+    capacity += JSON_OBJECT_SIZE(2) + JSON_ARRAY_SIZE(antennas[i].bands.size()) +
+                antennas[i].name.length() + 1;
+    for(const auto& band : antennas[i].bands) {
+      capacity += band.length() + 1;
+    }
+  }
+  return capacity;
+}
+
+size_t settingsJsonCapacity(size_t length) {
+  // Up to BAND_COUNT bands per antenna; the copied strings are never longer
+  // than the text they come from
+  return SETTINGS_JSON_FIXED_SIZE + JSON_ARRAY_SIZE(MATRIX_ANTENNAS) +
+         MATRIX_ANTENNAS * (JSON_OBJECT_SIZE(2) + JSON_ARRAY_SIZE(BAND_COUNT)) + length;
+}
+
 bool initializeStorage() {
   if(!SPIFFS.begin(true)) {
     Serial.println("SPIFFS Mount Failed");
@@ -12,12 +39,19 @@ bool initializeStorage() {
 }
 
 void loadSettings() {
+  for(int i = 0; i < MATRIX_ANTENNAS; i++) {
+    antennas[i].name = "Antenna " + String(i + 1);
+  }
+
   if(SPIFFS.exists("/settings.json")) {
     File file = SPIFFS.open("/settings.json", "r");
     if(file) {
-      DynamicJsonDocument doc(2048);
-      deserializeJson(doc, file);
+      DynamicJsonDocument doc(settingsJsonCapacity(file.size()));
+      DeserializationError error = deserializeJson(doc, file);
       file.close();
+      if(error) {
+        Serial.printf("Settings file: %s\n", error.c_str());
+      }
 
       if(doc.containsKey("mdnsHostname")) {
         const char* hostname = doc["mdnsHostname"];
@@ -37,10 +71,28 @@ void loadSettings() {
       if(doc.containsKey("otrspSerialEnabled")) {
         otrspSerialEnabled = doc["otrspSerialEnabled"].as<bool>();
       }
+      if(doc.containsKey("bandAutoSelect")) {
+        bandAutoSelect = doc["bandAutoSelect"].as<bool>();
+      }
+      if(doc.containsKey("serialBaud") && uart2BaudValid(doc["serialBaud"].as<uint32_t>())) {
+        serialBaud = doc["serialBaud"].as<uint32_t>();
+      }
+      if(doc.containsKey("serialAutobaud")) {
+        serialAutobaud = doc["serialAutobaud"].as<bool>();
+      }
+      if(doc.containsKey("relaySettleMs")) {
+        JsonArray radios = doc["relaySettleMs"].as<JsonArray>();
+        for(int r = 0; r < MATRIX_RADIOS && r < (int)radios.size(); r++) {
+          JsonArray times = radios[r].as<JsonArray>();
+          for(int a = 0; a < MATRIX_ANTENNAS && a < (int)times.size(); a++) {
+            setRelaySettleMs(r, a, times[a].as<uint16_t>());
+          }
+        }
+      }
       if(doc.containsKey("antennas")) {
         // New format: array of objects with name and bands
         JsonArray arr = doc["antennas"].as<JsonArray>();
-        for(int i = 0; i < 6 && i < (int)arr.size(); i++) {
+        for(int i = 0; i < MATRIX_ANTENNAS && i < (int)arr.size(); i++) {
           JsonObject obj = arr[i].as<JsonObject>();
           if(obj.containsKey("name")) {
             antennas[i].name = obj["name"].as<String>();
@@ -57,13 +109,13 @@ void loadSettings() {
         // Old format: separate antennaNames and antennaBands arrays
         if(doc.containsKey("antennaNames")) {
           JsonArray names = doc["antennaNames"].as<JsonArray>();
-          for(int i = 0; i < 6 && i < (int)names.size(); i++) {
+          for(int i = 0; i < MATRIX_ANTENNAS && i < (int)names.size(); i++) {
             antennas[i].name = names[i].as<String>();
           }
         }
         if(doc.containsKey("antennaBands")) {
           JsonArray bandsArr = doc["antennaBands"].as<JsonArray>();
-          for(int i = 0; i < 6 && i < (int)bandsArr.size(); i++) {
+          for(int i = 0; i < MATRIX_ANTENNAS && i < (int)bandsArr.size(); i++) {
             antennas[i].bands.clear();
             JsonArray bands = bandsArr[i].as<JsonArray>();
             for(int j = 0; j < (int)bands.size(); j++) {
@@ -74,17 +126,29 @@ void loadSettings() {
       }
     }
   }
+
+  rebuildBandIndex();
 }
 
-void saveSettings() {
-  DynamicJsonDocument doc(2048);
+bool saveSettings() {
+  DynamicJsonDocument doc(SETTINGS_JSON_FIXED_SIZE + antennasJsonCapacity());
   doc["mdnsHostname"] = mdnsHostname.c_str();
   doc["antennaSwapping"] = antennaSwappingEnabled;
   doc["singleRadioMode"] = singleRadioMode;
   doc["otrspEnabled"] = otrspEnabled;
   doc["otrspSerialEnabled"] = otrspSerialEnabled;
+  doc["bandAutoSelect"] = bandAutoSelect;
+  doc["serialBaud"] = serialBaud;
+  doc["serialAutobaud"] = serialAutobaud;
+  JsonArray settle = doc.createNestedArray("relaySettleMs");
+  for(int r = 0; r < MATRIX_RADIOS; r++) {
+    JsonArray times = settle.createNestedArray();
+    for(int a = 0; a < MATRIX_ANTENNAS; a++) {
+      times.add(getRelaySettleMs(r, a));
+    }
+  }
   JsonArray arr = doc.createNestedArray("antennas");
-  for(int i = 0; i < 6; i++) {
+  for(int i = 0; i < MATRIX_ANTENNAS; i++) {
     JsonObject obj = arr.createNestedObject();
     obj["name"] = antennas[i].name;
     JsonArray bands = obj.createNestedArray("bands");
@@ -92,12 +156,18 @@ void saveSettings() {
       bands.add(band);
     }
   }
+  if(doc.overflowed()) {
+    Serial.println("Settings do not fit the JSON document, not saved");
+    return false;
+  }
 
   File file = SPIFFS.open("/settings.json", "w");
-  if(file) {
-    serializeJson(doc, file);
-    file.close();
+  if(!file) {
+    return false;
   }
+  serializeJson(doc, file);
+  file.close();
+  return true;
 }
 
 String validateHostname(const String& input) {
@@ -0,0 +1,36 @@
+#include "uart2.h"
+#include "globals.h"
+#include "storage.h"
+
+void initializeUART2() {
+  Serial2.setRxBufferSize(UART2_RX_BUFFER);
+
+  if(serialAutobaud) {
+    // Baud 0 makes the core measure the rate from incoming edges
+    Serial.printf("UART2 autobaud, waiting %u ms for traffic\n", UART2_AUTOBAUD_TIMEOUT_MS);
+    Serial2.begin(0, SERIAL_8N1, RXD2, TXD2, false, UART2_AUTOBAUD_TIMEOUT_MS);
+    uint32_t detected = Serial2.baudRate();
+    if(detected && uart2BaudValid(detected)) {
+      Serial.printf("UART2 detected %u baud\n", detected);
+      if(detected != serialBaud) {
+        serialBaud = detected;
+        saveSettings();
+      }
+      return;
+    }
+    Serial.println("UART2 autobaud failed, using stored rate");
+  }
+
+  Serial2.begin(serialBaud, SERIAL_8N1, RXD2, TXD2);
+  Serial.printf("UART2 at %u baud\n", serialBaud);
+}
+
+bool uart2SetBaud(uint32_t baud) {
+  if(!uart2BaudValid(baud))
+    return false;
+  if(baud != serialBaud) {
+    Serial2.updateBaudRate(baud);
+    serialBaud = baud;
+  }
+  return true;
+}
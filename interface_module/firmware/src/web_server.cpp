@@ -5,11 +5,23 @@
 #include "antenna_hardware.h"
 #include "wifi_manager.h"
 #include "otrsp.h"
+#include "otrsp_trace.h"
+#include "latency_stats.h"
+#include "band_index.h"
+#include "uart2.h"
+#include "chunked_json.h"
 #include <WiFi.h>
 #include <ESPmDNS.h>
 #include <SPIFFS.h>
 #include <ArduinoJson.h>
 #include <Update.h>
+#include <esp_timer.h>
+#include <memory>
+#ifdef WEB_ASSETS_EMBEDDED
+#include "web_assets.h"
+#endif
+
+AsyncWebServer server(80);
 
 void initializeMDNS() {
   if (MDNS.begin(mdnsHostname.c_str())) {
@@ -20,62 +32,195 @@ void initializeMDNS() {
     
     // Add service to mDNS
     MDNS.addService("http", "tcp", 80);
-    MDNS.addService("ws", "tcp", 81);
+    MDNS.addService("ws", "tcp", 80);
     MDNS.addService("otrsp", "tcp", OTRSP_TCP_PORT);
   } else {
     Serial.println("Error setting up mDNS responder!");
   }
 }
 
-void initializeWebServer() {
-  // Static file routes
-  server.on("/", HTTP_GET, [](AsyncWebServerRequest *request){
-    request->send(SPIFFS, "/index.html", "text/html");
-  });
+// Pages and assets on SPIFFS. build_web.py stores them gzipped as
+// <path>.gz and lists each one with its ETag in /etags.txt; an image built
+// without it has the plain files and is served as before, uncached.
+// With WEB_ASSETS_EMBEDDED the gzipped files are compiled into flash
+// (web_assets.h) and SPIFFS is not read at all.
+struct StaticAsset {
+  const char* url;
+  const char* path;
+  const char* contentType;
+  char etag[20];  // "<16 hex digits>", empty if not gzipped
+  const uint8_t* data;  // embedded file, nullptr to read SPIFFS
+  size_t length;
+};
+
+static StaticAsset staticAssets[] = {
+  {"/", "/index.html", "text/html", ""},
+  {"/settings", "/settings.html", "text/html", ""},
+  {"/status", "/status.html", "text/html", ""},
+  {"/ota", "/ota.html", "text/html", ""},
+  {"/style.css", "/style.css", "text/css", ""},
+  {"/script.js", "/script.js", "text/javascript", ""},
+};
+
+// Pages are checked on every load (a 304 when unchanged) and link the
+// assets as <url>?v=<hash>, so a new asset has a new URL
+#define CACHE_PAGE  "no-cache"
+#define CACHE_ASSET "public, max-age=31536000, immutable"
+
+static void loadStaticAssets() {
+#ifdef WEB_ASSETS_EMBEDDED
+  for(auto& asset : staticAssets) {
+    for(size_t i = 0; i < embeddedAssetCount; i++) {
+      if(strcmp(embeddedAssets[i].path, asset.path) == 0) {
+        asset.data = embeddedAssets[i].data;
+        asset.length = embeddedAssets[i].length;
+        snprintf(asset.etag, sizeof(asset.etag), "%s", embeddedAssets[i].etag);
+      }
+    }
+  }
+#else
+  File file = SPIFFS.open("/etags.txt", "r");
+  if(!file)
+    return;
+
+  while(file.available()) {
+    String line = file.readStringUntil('\n');
+    int space = line.indexOf(' ');
+    if(space < 0)
+      continue;
+    String path = line.substring(0, space);
+    String etag = line.substring(space + 1);
+    etag.trim();
+    for(auto& asset : staticAssets) {
+      if(path == asset.path && SPIFFS.exists(path + ".gz"))
+        snprintf(asset.etag, sizeof(asset.etag), "%s", etag.c_str());
+    }
+  }
+  file.close();
+#endif
+}
 
-  server.on("/settings", HTTP_GET, [](AsyncWebServerRequest *request){
-    request->send(SPIFFS, "/settings.html", "text/html");
-  });
+static void sendStaticAsset(AsyncWebServerRequest* request, const StaticAsset& asset) {
+  if(asset.etag[0] == '\0') {
+    request->send(SPIFFS, asset.path, asset.contentType);
+    return;
+  }
 
-  server.on("/style.css", HTTP_GET, [](AsyncWebServerRequest *request){
-    request->send(SPIFFS, "/style.css", "text/css");
-  });
+  const char* cacheControl = strcmp(asset.contentType, "text/html") == 0 ? CACHE_PAGE : CACHE_ASSET;
+  AsyncWebServerResponse* response;
+  if(request->hasHeader("If-None-Match") &&
+     request->header("If-None-Match").indexOf(asset.etag) >= 0) {
+    // The browser's copy is current, no flash read
+    response = request->beginResponse(304);
+  } else {
+    // Embedded files are sent straight from flash, no copy in RAM
+    if(asset.data)
+      response = request->beginResponse_P(200, asset.contentType, asset.data, asset.length);
+    else
+      response = request->beginResponse(SPIFFS, String(asset.path) + ".gz", asset.contentType);
+    response->addHeader("Content-Encoding", "gzip");
+  }
+  response->addHeader("ETag", asset.etag);
+  response->addHeader("Cache-Control", cacheControl);
+  request->send(response);
+}
 
-  server.on("/script.js", HTTP_GET, [](AsyncWebServerRequest *request){
-    request->send(SPIFFS, "/script.js", "text/javascript");
-  });
+// JSON body printed into the chunked response as it is sent
+static AsyncWebServerResponse* beginChunkedJson(AsyncWebServerRequest* request,
+                                                ChunkedJson::Renderer render,
+                                                const char* contentType = "application/json") {
+  std::shared_ptr<ChunkedJson> body = std::make_shared<ChunkedJson>(render);
+  return request->beginChunkedResponse(contentType,
+    [body](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+      return body->fill(buffer, maxLen);
+    });
+}
 
-  server.on("/status", HTTP_GET, [](AsyncWebServerRequest *request){
-    request->send(SPIFFS, "/status.html", "text/html");
-  });
+static void printJsonString(Print& out, const char* text) {
+  StaticJsonDocument<16> doc;
+  doc.set(text);
+  serializeJson(doc, out);
+}
 
-  server.on("/ota", HTTP_GET, [](AsyncWebServerRequest *request){
-    request->send(SPIFFS, "/ota.html", "text/html");
-  });
+// {"name":"Dipole","bands":["20m","15m"]}, without a document, so its
+// size does not depend on the number of bands
+static void printAntenna(Print& out, uint8_t i) {
+  out.print("{\"name\":");
+  printJsonString(out, antennas[i].name.c_str());
+  out.print(",\"bands\":[");
+  for(size_t j = 0; j < antennas[i].bands.size(); j++) {
+    if(j > 0)
+      out.print(',');
+    printJsonString(out, antennas[i].bands[j].c_str());
+  }
+  out.print("]}");
+}
+
+// Settings export before the antennas list, one member per line
+static void printSettingsHead(Print& out) {
+  StaticJsonDocument<JSON_OBJECT_SIZE(9) + JSON_ARRAY_SIZE(MATRIX_RADIOS) +
+                     MATRIX_RADIOS * JSON_ARRAY_SIZE(MATRIX_ANTENNAS)> doc;
+  doc["mdnsHostname"] = mdnsHostname.c_str();
+  doc["antennaSwapping"] = antennaSwappingEnabled;
+  doc["singleRadioMode"] = singleRadioMode;
+  doc["otrspEnabled"] = otrspEnabled;
+  doc["otrspSerialEnabled"] = otrspSerialEnabled;
+  doc["bandAutoSelect"] = bandAutoSelect;
+  doc["serialBaud"] = serialBaud;
+  doc["serialAutobaud"] = serialAutobaud;
+  JsonArray settle = doc.createNestedArray("relaySettleMs");
+  for(int r = 0; r < MATRIX_RADIOS; r++) {
+    JsonArray times = settle.createNestedArray();
+    for(int a = 0; a < MATRIX_ANTENNAS; a++) {
+      times.add(getRelaySettleMs(r, a));
+    }
+  }
+
+  out.print("{\n");
+  for(JsonPair member : doc.as<JsonObject>()) {
+    out.print("  \"");
+    out.print(member.key().c_str());
+    out.print("\": ");
+    serializeJson(member.value(), out);
+    out.print(",\n");
+  }
+  out.print("  \"antennas\": [\n");
+}
+
+void initializeWebServer() {
+  // Static file routes
+  loadStaticAssets();
+  for(const auto& asset : staticAssets) {
+    server.on(asset.url, HTTP_GET, [&asset](AsyncWebServerRequest *request){
+      sendStaticAsset(request, asset);
+    });
+  }
 
   // Antenna management API
   server.on("/api/antennas", HTTP_GET, [](AsyncWebServerRequest *request){
-    DynamicJsonDocument doc(2048);
-    JsonArray array = doc.to<JsonArray>();
-    for(int i = 0; i < 6; i++) {
-      JsonObject ant = array.createNestedObject();
-      ant["name"] = antennas[i].name;
-      JsonArray bands = ant.createNestedArray("bands");
-      for(const auto& band : antennas[i].bands) {
-        bands.add(band);
+    // [, one antenna per piece, ]
+    request->send(beginChunkedJson(request, [](uint16_t index, Print& out) -> bool {
+      if(index > MATRIX_ANTENNAS)
+        return false;
+      if(index == MATRIX_ANTENNAS) {
+        out.print(']');
+      } else {
+        out.print(index == 0 ? '[' : ',');
+        printAntenna(out, index);
       }
-    }
-    String response;
-    serializeJson(doc, response);
-    request->send(200, "application/json", response);
+      return true;
+    }));
   });
 
   server.on("/api/antennas", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL,
     [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total){
-      DynamicJsonDocument doc(2048);
-      deserializeJson(doc, (char*)data);
+      DynamicJsonDocument doc(settingsJsonCapacity(len));
+      if(deserializeJson(doc, (const char*)data, len)) {
+        request->send(400, "text/plain", "Invalid JSON");
+        return;
+      }
 
-      for(int i = 0; i < 6; i++) {
+      for(int i = 0; i < MATRIX_ANTENNAS; i++) {
         String key = String(i);
         if(doc.containsKey(key)) {
           JsonVariant val = doc[key];
@@ -98,9 +243,14 @@ void initializeWebServer() {
         }
       }
 
-      saveSettings();
+      rebuildBandIndex();
+      bool saved = saveSettings();
       sendAntennaNameUpdate();
-      request->send(200, "text/plain", "OK");
+      if(saved) {
+        request->send(200, "text/plain", "OK");
+      } else {
+        request->send(500, "text/plain", "Settings not saved");
+      }
     });
 
   // Individual antenna name management
@@ -108,7 +258,7 @@ void initializeWebServer() {
     String antennaStr = request->pathArg(0);
     int antennaIndex = antennaStr.toInt();
 
-    if(antennaIndex >= 0 && antennaIndex < 6) {
+    if(antennaIndex >= 0 && antennaIndex < MATRIX_ANTENNAS) {
       DynamicJsonDocument doc(512);
       doc["index"] = antennaIndex;
       doc["name"] = antennas[antennaIndex].name;
@@ -130,7 +280,7 @@ void initializeWebServer() {
       String antennaStr = request->pathArg(0);
       int antennaIndex = antennaStr.toInt();
 
-      if(antennaIndex >= 0 && antennaIndex < 6) {
+      if(antennaIndex >= 0 && antennaIndex < MATRIX_ANTENNAS) {
         DynamicJsonDocument doc(512);
         deserializeJson(doc, (char*)data);
 
@@ -149,9 +299,14 @@ void initializeWebServer() {
         }
 
         if(updated) {
-          saveSettings();
+          rebuildBandIndex();
+          bool saved = saveSettings();
           sendAntennaNameUpdate();
-          request->send(200, "text/plain", "OK");
+          if(saved) {
+            request->send(200, "text/plain", "OK");
+          } else {
+            request->send(500, "text/plain", "Settings not saved");
+          }
         } else {
           request->send(400, "text/plain", "Missing 'name' or 'bands' field");
         }
@@ -163,8 +318,9 @@ void initializeWebServer() {
   // State API
   server.on("/api/state", HTTP_GET, [](AsyncWebServerRequest *request){
     DynamicJsonDocument doc(200);
-    doc["radio1"] = currentAntenna[0];
-    doc["radio2"] = currentAntenna[1];
+    for(uint8_t r = 0; r < MATRIX_RADIOS; r++) {
+      doc[String("radio") + (r + 1)] = currentAntenna[r];
+    }
     String response;
     serializeJson(doc, response);
     request->send(200, "application/json", response);
@@ -203,6 +359,7 @@ void initializeWebServer() {
     DynamicJsonDocument doc(256);
     doc["antennaSwapping"] = antennaSwappingEnabled;
     doc["singleRadioMode"] = singleRadioMode;
+    doc["bandAutoSelect"] = bandAutoSelect;
     String response;
     serializeJson(doc, response);
     request->send(200, "application/json", response);
@@ -210,6 +367,7 @@ void initializeWebServer() {
 
   server.on("/api/operation-mode", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL, 
     [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total){
+      uint32_t receivedAt = micros();
       DynamicJsonDocument doc(256);
       deserializeJson(doc, (char*)data);
       
@@ -220,22 +378,93 @@ void initializeWebServer() {
       if(doc.containsKey("singleRadioMode")) {
         bool newSingleRadioMode = doc["singleRadioMode"].as<bool>();
         
-        // If enabling single radio mode, disconnect radio 2
+        // If enabling single radio mode, disconnect every radio but the first
         if(newSingleRadioMode && !singleRadioMode) {
-          if(currentAntenna[1] > 0) {
-            digitalWrite(relay[1][currentAntenna[1]-1], 0);
-            currentAntenna[1] = 0;
-          }
+          latencyBegin(LATENCY_REST, receivedAt);
+          disconnectOtherRadios();
+          latencyEnd();
+          otrspPushNow();
         }
         
         singleRadioMode = newSingleRadioMode;
       }
+
+      if(doc.containsKey("bandAutoSelect")) {
+        bandAutoSelect = doc["bandAutoSelect"].as<bool>();
+      }
       
       saveSettings();
       sendWebSocketUpdate(); // Update the UI with new state
       request->send(200, "text/plain", "OK");
     });
 
+  // Ingress-to-GPIO latency per command source
+  server.on("/api/stats/latency", HTTP_GET, [](AsyncWebServerRequest *request){
+    DynamicJsonDocument doc(768);
+    for(uint8_t s = 0; s < LATENCY_SOURCES; s++) {
+      LatencySummary sum = latencySummary((LatencySource)s);
+      JsonObject src = doc.createNestedObject(latencySourceName((LatencySource)s));
+      src["count"] = sum.count;
+      src["p50Us"] = sum.p50Us;
+      src["p99Us"] = sum.p99Us;
+      src["maxUs"] = sum.maxUs;
+    }
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+  });
+
+  server.on("/api/stats/latency", HTTP_DELETE, [](AsyncWebServerRequest *request){
+    latencyReset();
+    request->send(200, "text/plain", "OK");
+  });
+
+  // Relay timing: per-relay settle times and the last switch sequence
+  server.on("/api/relay-timing", HTTP_GET, [](AsyncWebServerRequest *request){
+    DynamicJsonDocument doc(512);
+    JsonArray settle = doc.createNestedArray("settleMs");
+    for(int r = 0; r < MATRIX_RADIOS; r++) {
+      JsonArray times = settle.createNestedArray();
+      for(int a = 0; a < MATRIX_ANTENNAS; a++) {
+        times.add(getRelaySettleMs(r, a));
+      }
+    }
+    SwitchTrace trace = getSwitchTrace();
+    JsonObject last = doc.createNestedObject("lastSwitch");
+    // Step times relative to the switch request, absent if no such step
+    if(trace.breakUs > 0) {
+      last["breakUs"] = (uint32_t)(trace.breakUs - trace.requestUs);
+    }
+    if(trace.makeUs > 0) {
+      last["makeUs"] = (uint32_t)(trace.makeUs - trace.requestUs);
+    }
+    last["agoMs"] = (uint32_t)((esp_timer_get_time() - trace.requestUs) / 1000);
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+  });
+
+  server.on("/api/relay-timing", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL,
+    [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total){
+      DynamicJsonDocument doc(512);
+      deserializeJson(doc, (char*)data);
+
+      if(!doc.containsKey("settleMs")) {
+        request->send(400, "text/plain", "Missing 'settleMs' field");
+        return;
+      }
+
+      JsonArray radios = doc["settleMs"].as<JsonArray>();
+      for(int r = 0; r < MATRIX_RADIOS && r < (int)radios.size(); r++) {
+        JsonArray times = radios[r].as<JsonArray>();
+        for(int a = 0; a < MATRIX_ANTENNAS && a < (int)times.size(); a++) {
+          setRelaySettleMs(r, a, times[a].as<uint16_t>());
+        }
+      }
+      saveSettings();
+      request->send(200, "text/plain", "OK");
+    });
+
   // Admin endpoints
   server.on("/api/reboot", HTTP_POST, [](AsyncWebServerRequest *request){
     request->send(200, "text/plain", "Device rebooting...");
@@ -250,25 +479,21 @@ void initializeWebServer() {
 
   // Settings export
   server.on("/api/settings/export", HTTP_GET, [](AsyncWebServerRequest *request){
-    DynamicJsonDocument doc(2048);
-    doc["mdnsHostname"] = mdnsHostname.c_str();
-    doc["antennaSwapping"] = antennaSwappingEnabled;
-    doc["singleRadioMode"] = singleRadioMode;
-    doc["otrspEnabled"] = otrspEnabled;
-    doc["otrspSerialEnabled"] = otrspSerialEnabled;
-    JsonArray arr = doc.createNestedArray("antennas");
-    for(int i = 0; i < 6; i++) {
-      JsonObject obj = arr.createNestedObject();
-      obj["name"] = antennas[i].name;
-      JsonArray bands = obj.createNestedArray("bands");
-      for(const auto& band : antennas[i].bands) {
-        bands.add(band);
+    // Settings, one antenna per piece, closing brackets
+    AsyncWebServerResponse *resp = beginChunkedJson(request, [](uint16_t index, Print& out) -> bool {
+      if(index > MATRIX_ANTENNAS + 1)
+        return false;
+      if(index == 0) {
+        printSettingsHead(out);
+      } else if(index <= MATRIX_ANTENNAS) {
+        out.print("    ");
+        printAntenna(out, index - 1);
+        out.print(index < MATRIX_ANTENNAS ? ",\n" : "\n");
+      } else {
+        out.print("  ]\n}\n");
       }
-    }
-
-    String response;
-    serializeJsonPretty(doc, response);
-    AsyncWebServerResponse *resp = request->beginResponse(200, "application/json", response);
+      return true;
+    });
     resp->addHeader("Content-Disposition", "attachment; filename=\"settings.json\"");
     request->send(resp);
   });
@@ -276,8 +501,9 @@ void initializeWebServer() {
   // Settings import
   server.on("/api/settings/import", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL,
     [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total){
-      DynamicJsonDocument doc(2048);
-      DeserializationError error = deserializeJson(doc, (char*)data);
+      uint32_t receivedAt = micros();
+      DynamicJsonDocument doc(settingsJsonCapacity(len));
+      DeserializationError error = deserializeJson(doc, (const char*)data, len);
 
       if(error) {
         request->send(400, "text/plain", "Invalid JSON");
@@ -296,10 +522,10 @@ void initializeWebServer() {
       if(doc.containsKey("singleRadioMode")) {
         bool newSingleRadioMode = doc["singleRadioMode"].as<bool>();
         if(newSingleRadioMode && !singleRadioMode) {
-          if(currentAntenna[1] > 0) {
-            digitalWrite(relay[1][currentAntenna[1]-1], 0);
-            currentAntenna[1] = 0;
-          }
+          latencyBegin(LATENCY_REST, receivedAt);
+          disconnectOtherRadios();
+          latencyEnd();
+          otrspPushNow();
         }
         singleRadioMode = newSingleRadioMode;
       }
@@ -309,10 +535,28 @@ void initializeWebServer() {
       if(doc.containsKey("otrspSerialEnabled")) {
         otrspSerialEnabled = doc["otrspSerialEnabled"].as<bool>();
       }
+      if(doc.containsKey("bandAutoSelect")) {
+        bandAutoSelect = doc["bandAutoSelect"].as<bool>();
+      }
+      if(doc.containsKey("serialBaud")) {
+        uart2SetBaud(doc["serialBaud"].as<uint32_t>());
+      }
+      if(doc.containsKey("serialAutobaud")) {
+        serialAutobaud = doc["serialAutobaud"].as<bool>();
+      }
+      if(doc.containsKey("relaySettleMs")) {
+        JsonArray radios = doc["relaySettleMs"].as<JsonArray>();
+        for(int r = 0; r < MATRIX_RADIOS && r < (int)radios.size(); r++) {
+          JsonArray times = radios[r].as<JsonArray>();
+          for(int a = 0; a < MATRIX_ANTENNAS && a < (int)times.size(); a++) {
+            setRelaySettleMs(r, a, times[a].as<uint16_t>());
+          }
+        }
+      }
       if(doc.containsKey("antennas")) {
         // New format: array of objects
         JsonArray arr = doc["antennas"].as<JsonArray>();
-        for(int i = 0; i < 6 && i < (int)arr.size(); i++) {
+        for(int i = 0; i < MATRIX_ANTENNAS && i < (int)arr.size(); i++) {
           JsonObject obj = arr[i].as<JsonObject>();
           if(obj.containsKey("name")) {
             antennas[i].name = obj["name"].as<String>();
@@ -329,13 +573,13 @@ void initializeWebServer() {
         // Old format: separate arrays
         if(doc.containsKey("antennaNames")) {
           JsonArray names = doc["antennaNames"].as<JsonArray>();
-          for(int i = 0; i < 6 && i < (int)names.size(); i++) {
+          for(int i = 0; i < MATRIX_ANTENNAS && i < (int)names.size(); i++) {
             antennas[i].name = names[i].as<String>();
           }
         }
         if(doc.containsKey("antennaBands")) {
           JsonArray bandsArr = doc["antennaBands"].as<JsonArray>();
-          for(int i = 0; i < 6 && i < (int)bandsArr.size(); i++) {
+          for(int i = 0; i < MATRIX_ANTENNAS && i < (int)bandsArr.size(); i++) {
             antennas[i].bands.clear();
             JsonArray bands = bandsArr[i].as<JsonArray>();
             for(int j = 0; j < (int)bands.size(); j++) {
@@ -345,15 +589,24 @@ void initializeWebServer() {
         }
       }
 
-      saveSettings();
+      rebuildBandIndex();
+      bool saved = saveSettings();
       sendWebSocketUpdate();
       sendAntennaNameUpdate();
-      request->send(200, "text/plain", "Settings imported successfully");
+      if(saved) {
+        request->send(200, "text/plain", "Settings imported successfully");
+      } else {
+        request->send(500, "text/plain", "Settings imported but not saved");
+      }
     });
 
   // Status API
   server.on("/api/status", HTTP_GET, [](AsyncWebServerRequest *request){
-    DynamicJsonDocument doc(1024);
+    // Values are taken once into the document (strings copied), so the
+    // response is one snapshot; its size does not grow with the
+    // configuration
+    std::shared_ptr<DynamicJsonDocument> status = std::make_shared<DynamicJsonDocument>(1024);
+    DynamicJsonDocument& doc = *status;
     
     // WiFi information
     doc["ssid"] = WiFi.SSID();
@@ -387,12 +640,19 @@ void initializeWebServer() {
     doc["uptime"] = millis() / 1000;
     
     // Current antenna state
-    doc["currentRadio1"] = currentAntenna[0];
-    doc["currentRadio2"] = currentAntenna[1];
-    
-    String response;
-    serializeJson(doc, response);
-    request->send(200, "application/json", response);
+    doc["matrixRadios"] = MATRIX_RADIOS;
+    doc["matrixAntennas"] = MATRIX_ANTENNAS;
+    for(uint8_t r = 0; r < MATRIX_RADIOS; r++) {
+      doc[String("currentRadio") + (r + 1)] = currentAntenna[r];
+    }
+    doc["relaySwitchCycles"] = getLastSwitchCycles();
+
+    request->send(beginChunkedJson(request, [status](uint16_t index, Print& out) -> bool {
+      if(index > 0)
+        return false;
+      serializeJson(*status, out);
+      return true;
+    }));
   });
 
   // OTA Update endpoint
@@ -412,13 +672,8 @@ void initializeWebServer() {
         Serial.printf("Update Start: %s\n", filename.c_str());
         
         // Turn off all relays during update
-        for(uint8_t radio = 0; radio < 2; radio++) {
-          for(uint8_t antenna = 0; antenna < 6; antenna++) {
-            digitalWrite(relay[radio][antenna], LOW);
-          }
-        }
-        currentAntenna[0] = 0;
-        currentAntenna[1] = 0;
+        disconnectAll();
+        otrspPushNow();
         
         // Determine update type based on filename
         int cmd;
@@ -472,17 +727,38 @@ void initializeWebServer() {
 
   // OTRSP status API
   server.on("/api/otrsp/status", HTTP_GET, [](AsyncWebServerRequest *request){
-    DynamicJsonDocument doc(512);
+    DynamicJsonDocument doc(1536);
     doc["enabled"] = otrspEnabled;
     doc["serialEnabled"] = otrspSerialEnabled;
     doc["tcpPort"] = OTRSP_TCP_PORT;
-    doc["clientConnected"] = otrspState.clientConnected;
+    doc["clientConnected"] = otrspState.clients > 0;
+    doc["maxClients"] = OTRSP_MAX_CLIENTS;
+    JsonArray clientsArr = doc.createNestedArray("clients");
+    for(uint8_t slot = 0; slot < OTRSP_MAX_CLIENTS; slot++) {
+      OTRSPClientInfo info;
+      if(!otrspClientInfo(slot, &info))
+        continue;
+      JsonObject c = clientsArr.createNestedObject();
+      c["slot"] = slot + 1;
+      c["remote"] = IPAddress(info.ip).toString() + ":" + info.port;
+      c["connectedMs"] = info.connectedMs;
+      c["lines"] = info.lines;
+      c["serviceUs"] = info.serviceUs;
+    }
+    doc["packetUs"] = otrspPacketUs();
+    doc["bytesPerClient"] = otrspClientBytes();
     doc["txFocus"] = otrspState.txFocus;
     doc["rxFocus"] = otrspState.rxFocus;
     doc["band1"] = otrspState.band[0];
     doc["band2"] = otrspState.band[1];
     doc["mode1"] = String(otrspState.mode[0]);
     doc["mode2"] = String(otrspState.mode[1]);
+    OTRSPTraceStatus trace = otrspTraceStatus();
+    JsonObject traceObj = doc.createNestedObject("trace");
+    traceObj["capture"] = trace.active;
+    traceObj["records"] = trace.records;
+    traceObj["overwritten"] = trace.overwritten;
+    traceObj["bytes"] = trace.bytes;
     String response;
     serializeJson(doc, response);
     request->send(200, "application/json", response);
@@ -504,6 +780,87 @@ void initializeWebServer() {
       request->send(200, "text/plain", "OK - Restart required for TCP changes to take effect");
     });
 
+  // OTRSP capture: start/stop and trace download
+  // Streamed from the ring one line per piece, like the chunked JSON
+  // bodies. Each line is read once and kept, as a piece split across two
+  // chunks is printed twice.
+  server.on("/api/otrsp/trace", HTTP_GET, [](AsyncWebServerRequest *request){
+    struct TraceBody {
+      OTRSPTraceCursor cursor;
+      int32_t index;
+      size_t len;
+      char line[OTRSP_TRACE_LINE_SIZE];
+    };
+    std::shared_ptr<TraceBody> body = std::make_shared<TraceBody>();
+    otrspTraceRewind(body->cursor);
+    body->index = -1;
+
+    AsyncWebServerResponse *response = beginChunkedJson(request, [body](uint16_t index, Print& out) -> bool {
+      if(index != body->index) {
+        body->index = index;
+        body->len = otrspTraceNextLine(body->cursor, body->line, sizeof(body->line));
+      }
+      if(body->len == 0)
+        return false;
+      out.write((const uint8_t*)body->line, body->len);
+      return true;
+    }, "text/plain");
+    response->addHeader("Content-Disposition", "attachment; filename=\"otrsp-trace.txt\"");
+    request->send(response);
+  });
+
+  server.on("/api/otrsp/trace", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL,
+    [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total){
+      DynamicJsonDocument doc(64);
+      deserializeJson(doc, (char*)data);
+
+      if(!doc.containsKey("capture")) {
+        request->send(400, "text/plain", "Missing 'capture' field");
+        return;
+      }
+      if(!doc["capture"].as<bool>()) {
+        otrspTraceStop();
+      } else if(!otrspTraceStart()) {
+        request->send(500, "text/plain", "Out of memory for the trace buffer");
+        return;
+      }
+      request->send(200, "text/plain", "OK");
+    });
+
+  // UART2 (RS-485) rate
+  server.on("/api/serial", HTTP_GET, [](AsyncWebServerRequest *request){
+    DynamicJsonDocument doc(256);
+    doc["baud"] = serialBaud;
+    doc["autobaud"] = serialAutobaud;
+    JsonArray rates = doc.createNestedArray("rates");
+    for(size_t i = 0; i < UART2_RATE_COUNT; i++) {
+      rates.add(UART2_RATES[i]);
+    }
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+  });
+
+  server.on("/api/serial", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL,
+    [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total){
+      DynamicJsonDocument doc(128);
+      DeserializationError error = deserializeJson(doc, (char*)data);
+
+      if(error) {
+        request->send(400, "text/plain", "Invalid JSON");
+        return;
+      }
+      if(doc.containsKey("baud") && !uart2SetBaud(doc["baud"].as<uint32_t>())) {
+        request->send(400, "text/plain", "Unsupported baud rate");
+        return;
+      }
+      if(doc.containsKey("autobaud")) {
+        serialAutobaud = doc["autobaud"].as<bool>();
+      }
+      saveSettings();
+      request->send(200, "text/plain", "OK");
+    });
+
   server.begin();
   Serial.println("HTTP server started");
 }
@@ -1,24 +1,155 @@
 #include "websocket.h"
 #include "globals.h"
 #include "antenna_hardware.h"
+#include "latency_stats.h"
+#include "ws_binary.h"
+#include "storage.h"
+#include "otrsp.h"
+#include <ESPAsyncWebServer.h>
+#include <ArduinoJson.h>
 
-void sendWebSocketUpdate() {
-  DynamicJsonDocument doc(300);
-  doc["type"] = "state";
-  doc["radio1"] = currentAntenna[0];
-  doc["radio2"] = currentAntenna[1];
-  doc["singleRadioMode"] = singleRadioMode;
-  
-  String message;
-  serializeJson(doc, message);
-  webSocket.broadcastTXT(message);
+// {"type":"state","radio1":3,...,"singleRadioMode":false,"antennaSwapping":false,
+//  "epoch":4294967295,"version":4294967295}
+#define WS_STATE_FRAME_SIZE (112 + MATRIX_RADIOS * 16)
+
+// Clients connected since the last loop() pass, waiting for their
+// first state and names frames
+#define WS_WELCOME_QUEUE  8
+
+// How often closed clients are released
+#define WS_CLEANUP_MS     1000
+
+// JSON clients on /ws, binary protocol clients on /ws/bin, both on the
+// port 80 web server
+static AsyncWebSocket ws(WS_PATH);
+static AsyncWebSocket wsBin(WSB_PATH);
+
+// Antenna names frame, serialized when the configuration changes and
+// sent as is to every client that connects. Rendered on the task that
+// changed the antennas (AsyncTCP for the REST handlers), sent by loop();
+// namesMutex guards the frame between the two. The buffer is made by ws
+// and shared by the messages of all clients of both sockets; the cache
+// holds one reference so ws does not free it while it is current.
+static AsyncWebSocketMessageBuffer* antennaNamesFrame = nullptr;
+static SemaphoreHandle_t namesMutex = nullptr;
+
+static uint16_t stateSeq = 0;
+
+// State versions. syncVersion counts changes since boot; each field
+// keeps the version it last changed at, so a client reconnecting with
+// the last version it saw is sent only the fields changed after it.
+// The epoch is drawn at boot and tells versions of an earlier boot apart.
+// Changes are picked up from the globals by captureState() in loop().
+struct SyncedState {
+  uint8_t antenna[MATRIX_RADIOS];
+  bool singleRadioMode;
+  bool antennaSwapping;
+};
+static SyncedState synced;
+static uint32_t syncEpoch = 0;
+static uint32_t syncVersion = 1;
+static uint32_t antennaVersion[MATRIX_RADIOS];
+static uint32_t singleRadioVersion = 1;
+static uint32_t swappingVersion = 1;
+static uint32_t namesVersion = 1;
+static uint32_t stateVersion = 1;      // latest change of any state field or the names
+static uint32_t broadcastVersion = 1;  // state version last sent to all
+
+// Broadcasts requested from any task, sent by loop() once per tick
+static volatile bool stateDirty = false;
+static volatile bool namesDirty = false;
+static volatile bool otaDirty = false;
+static uint32_t lastBroadcast = 0;
+static uint32_t lastCleanup = 0;
+
+// Latest OTA status, earlier progress steps are dropped
+struct OTAStatus {
+  char status[12];
+  char message[48];
+  uint8_t progress;
+};
+static OTAStatus pendingOTA;
+static portMUX_TYPE otaMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Connect events arrive on the AsyncTCP task; loop() sends the first
+// frames
+struct WelcomeEntry {
+  AsyncWebSocket* server;
+  uint32_t id;
+  uint32_t since;  // version the client has seen, 0 for a snapshot
+};
+static WelcomeEntry welcome[WS_WELCOME_QUEUE];
+static uint8_t welcomeCount = 0;
+static bool welcomeOverflow = false;
+static portMUX_TYPE welcomeMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Take changes of the globals into the synced state, one new version
+// for everything changed since the last call
+static void captureState() {
+  uint32_t next = syncVersion + 1;
+  bool changed = false;
+
+  for(uint8_t r = 0; r < MATRIX_RADIOS; r++) {
+    uint8_t antenna = currentAntenna[r];
+    if(antenna != synced.antenna[r]) {
+      synced.antenna[r] = antenna;
+      antennaVersion[r] = next;
+      changed = true;
+    }
+  }
+  if(singleRadioMode != synced.singleRadioMode) {
+    synced.singleRadioMode = singleRadioMode;
+    singleRadioVersion = next;
+    changed = true;
+  }
+  if(antennaSwappingEnabled != synced.antennaSwapping) {
+    synced.antennaSwapping = antennaSwappingEnabled;
+    swappingVersion = next;
+    changed = true;
+  }
+
+  if(changed) {
+    syncVersion = next;
+    stateVersion = next;
+  }
 }
 
-void sendAntennaNameUpdate() {
-  DynamicJsonDocument doc(2048);
+// Render the state frame on the stack, no heap allocation. With since
+// set, a delta frame holding only the fields changed after that version.
+static size_t renderStateFrame(char* frame, size_t size, uint32_t since = 0) {
+  size_t len = snprintf(frame, size, "{\"type\":\"%s\"", since ? "delta" : "state");
+  for(uint8_t r = 0; r < MATRIX_RADIOS; r++) {
+    if(antennaVersion[r] > since)
+      len += snprintf(frame + len, size - len, ",\"radio%u\":%u", r + 1, synced.antenna[r]);
+  }
+  if(singleRadioVersion > since)
+    len += snprintf(frame + len, size - len, ",\"singleRadioMode\":%s",
+                    synced.singleRadioMode ? "true" : "false");
+  if(swappingVersion > since)
+    len += snprintf(frame + len, size - len, ",\"antennaSwapping\":%s",
+                    synced.antennaSwapping ? "true" : "false");
+  len += snprintf(frame + len, size - len, ",\"epoch\":%lu,\"version\":%lu}",
+                  (unsigned long)syncEpoch, (unsigned long)syncVersion);
+  return len;
+}
+
+static void renderBinaryState(uint8_t* frame) {
+  frame[0] = WSB_STATE;
+  frame[1] = stateSeq & 0xFF;
+  frame[2] = stateSeq >> 8;
+  frame[3] = synced.singleRadioMode ? WSB_FLAG_SINGLE_RADIO : 0;
+  for(uint8_t r = 0; r < MATRIX_RADIOS; r++) {
+    frame[4 + r] = synced.antenna[r];
+  }
+}
+
+// Serialize the names from antennas[] into the cache. Runs on the task
+// that changes antennas[], so it never sees them half updated.
+static void renderAntennaNames() {
+  DynamicJsonDocument doc(JSON_OBJECT_SIZE(2) + antennasJsonCapacity());
   doc["type"] = "antennaNames";
   JsonArray antennasArr = doc.createNestedArray("antennas");
-  for(int i = 0; i < 6; i++) {
+  for(int i = 0; i < MATRIX_ANTENNAS; i++) {
     JsonObject ant = antennasArr.createNestedObject();
     ant["name"] = antennas[i].name;
     JsonArray bands = ant.createNestedArray("bands");
@@ -27,55 +158,327 @@ void sendAntennaNameUpdate() {
     }
   }
 
-  String message;
-  serializeJson(doc, message);
-  webSocket.broadcastTXT(message);
+  if(doc.overflowed()) {
+    Serial.println("Antenna names do not fit the JSON document");
+  }
+
+  size_t len = measureJson(doc);
+  AsyncWebSocketMessageBuffer* frame = ws.makeBuffer(len);
+  if(!frame)
+    return;
+  serializeJson(doc, (char*)frame->get(), len + 1);
+  (*frame)++;
+
+  // ws frees the old frame once the messages still using it are sent
+  xSemaphoreTake(namesMutex, portMAX_DELAY);
+  AsyncWebSocketMessageBuffer* old = antennaNamesFrame;
+  antennaNamesFrame = frame;
+  if(old)
+    (*old)--;
+  xSemaphoreGive(namesMutex);
 }
 
-void sendOTAStatus(const String& status, const String& message, uint8_t progress) {
-  DynamicJsonDocument doc(300);
-  doc["type"] = "ota";
-  doc["status"] = status;
-  doc["message"] = message;
-  doc["progress"] = progress;
-  
-  String jsonMessage;
-  serializeJson(doc, jsonMessage);
-  webSocket.broadcastTXT(jsonMessage);
-}
-
-void webSocketEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t length) {
+// One copy of a text frame for the clients of both sockets. The buffer
+// is ws's; the extra reference keeps the cleanup at the end of
+// ws.textAll() from freeing it before wsBin has queued it.
+static void textAllBoth(AsyncWebSocketMessageBuffer* buffer) {
+  (*buffer)++;
+  ws.textAll(buffer);
+  wsBin.textAll(buffer);
+  (*buffer)--;
+}
+
+// Send the state to every client if it changed since the last
+// broadcast, or in any case with force
+static void broadcastState(bool force = false) {
+  captureState();
+  if(stateVersion == broadcastVersion && !force)
+    return;
+  broadcastVersion = stateVersion;
+  stateSeq++;
+  // Rendered on the stack, then copied once into a buffer every
+  // client's message shares
+  if(ws.count() > 0) {
+    char frame[WS_STATE_FRAME_SIZE];
+    size_t len = renderStateFrame(frame, sizeof(frame));
+    AsyncWebSocketMessageBuffer* buffer = ws.makeBuffer((uint8_t*)frame, len);
+    if(buffer)
+      ws.textAll(buffer);
+  }
+  if(wsBin.count() > 0) {
+    uint8_t frame[WSB_STATE_SIZE];
+    renderBinaryState(frame);
+    AsyncWebSocketMessageBuffer* buffer = wsBin.makeBuffer(frame, sizeof(frame));
+    if(buffer)
+      wsBin.binaryAll(buffer);
+  }
+}
+
+static void broadcastNames() {
+  xSemaphoreTake(namesMutex, portMAX_DELAY);
+  if(antennaNamesFrame)
+    textAllBoth(antennaNamesFrame);
+  xSemaphoreGive(namesMutex);
+}
+
+// The cached names unless the client has them, then the state in the
+// client's protocol. JSON clients that sent a version get a delta; it
+// carries the current version, so it goes last.
+static void sendWelcome(const WelcomeEntry& entry) {
+  // A version from the future was not counted by this boot
+  uint32_t since = entry.since <= syncVersion ? entry.since : 0;
+
+  AsyncWebSocketClient* client = entry.server->client(entry.id);
+  if(client && (since == 0 || namesVersion > since)) {
+    xSemaphoreTake(namesMutex, portMAX_DELAY);
+    if(antennaNamesFrame)
+      client->text(antennaNamesFrame);
+    xSemaphoreGive(namesMutex);
+  }
+
+  if(entry.server == &wsBin) {
+    uint8_t frame[WSB_STATE_SIZE];
+    renderBinaryState(frame);
+    wsBin.binary(entry.id, (const char*)frame, sizeof(frame));
+  } else {
+    char frame[WS_STATE_FRAME_SIZE];
+    size_t len = renderStateFrame(frame, sizeof(frame), since);
+    ws.text(entry.id, frame, len);
+  }
+}
+
+static void handleWelcome() {
+  WelcomeEntry entries[WS_WELCOME_QUEUE];
+  uint8_t count;
+  bool overflow;
+
+  portENTER_CRITICAL(&welcomeMux);
+  count = welcomeCount;
+  overflow = welcomeOverflow;
+  memcpy(entries, welcome, count * sizeof(WelcomeEntry));
+  welcomeCount = 0;
+  welcomeOverflow = false;
+  portEXIT_CRITICAL(&welcomeMux);
+
+  if(count == 0 && !overflow)
+    return;
+
+  // A change not broadcast yet goes to the other clients next tick
+  captureState();
+  if(stateVersion != broadcastVersion)
+    stateDirty = true;
+
+  // More clients than the queue holds: everyone gets the frames again
+  if(overflow) {
+    broadcastNames();
+    broadcastState(true);
+    return;
+  }
+  for(uint8_t i = 0; i < count; i++)
+    sendWelcome(entries[i]);
+}
+
+static void handleJsonMessage(const uint8_t* data, size_t len, uint32_t receivedAt) {
+  DynamicJsonDocument doc(JSON_OBJECT_SIZE(3) + JSON_ARRAY_SIZE(MATRIX_RADIOS) +
+                          MATRIX_RADIOS * JSON_OBJECT_SIZE(2) + 96);
+  if(deserializeJson(doc, (const char*)data, len))
+    return;
+
+  if(doc["type"] == "select") {
+    uint8_t radio = doc["radio"];
+    uint8_t antenna = doc["antenna"];
+    latencyBegin(LATENCY_WEBSOCKET, receivedAt);
+    selectAntenna(radio, antenna);
+    latencyEnd();
+    otrspPushNow();
+  }
+  else if(doc["type"] == "batch") {
+    // {"type":"batch","select":[{"radio":0,"antenna":3},{"radio":1,"antenna":5}]}
+    JsonArray items = doc["select"].as<JsonArray>();
+    AntennaSelection selections[MATRIX_RADIOS];
+    uint8_t count = 0;
+    if(items.size() > 0 && items.size() <= MATRIX_RADIOS) {
+      for(JsonObject item : items) {
+        selections[count].radio = item["radio"] | 0xFF;
+        selections[count].antenna = item["antenna"] | 0xFF;
+        count++;
+      }
+      latencyBegin(LATENCY_WEBSOCKET, receivedAt);
+      selectAntennas(selections, count);
+      latencyEnd();
+      otrspPushNow();
+    }
+  }
+}
+
+// SELECT: one pair switches like a JSON select, several as one batch
+static void handleBinarySelect(AsyncWebSocketClient* client, const uint8_t* payload, size_t length,
+                               uint32_t receivedAt) {
+  uint8_t ack[WSB_ACK_SIZE] = {WSB_ACK, 0, WSB_RESULT_MALFORMED};
+  if(length >= 2)
+    ack[1] = payload[1];
+
+  uint8_t count = length >= WSB_SELECT_HEADER ? payload[2] : 0;
+  if(count > 0 && count <= MATRIX_RADIOS && length == WSB_SELECT_HEADER + 2u * count) {
+    const uint8_t* pairs = payload + WSB_SELECT_HEADER;
+    latencyBegin(LATENCY_WEBSOCKET, receivedAt);
+    if(count == 1) {
+      ack[2] = selectAntenna(pairs[0], pairs[1]);
+    } else {
+      AntennaSelection selections[MATRIX_RADIOS];
+      for(uint8_t i = 0; i < count; i++) {
+        selections[i].radio = pairs[2 * i];
+        selections[i].antenna = pairs[2 * i + 1];
+      }
+      ack[2] = selectAntennas(selections, count);
+    }
+    latencyEnd();
+    otrspPushNow();
+  }
+  client->binary((const char*)ack, sizeof(ack));
+}
+
+// Version from the ?epoch=&version= query of a reconnecting client, 0
+// if it has none or it was counted by an earlier boot
+static uint32_t resyncVersion(AsyncWebServerRequest* request) {
+  if(!request || !request->hasParam("epoch") || !request->hasParam("version"))
+    return 0;
+  uint32_t epoch = strtoul(request->getParam("epoch")->value().c_str(), NULL, 10);
+  if(epoch != syncEpoch)
+    return 0;
+  return strtoul(request->getParam("version")->value().c_str(), NULL, 10);
+}
+
+static void onWebSocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type,
+                             void* arg, uint8_t* data, size_t len) {
+  uint32_t receivedAt = micros();
+
   switch(type) {
-    case WStype_DISCONNECTED:
-      Serial.printf("[%u] Disconnected!\n", num);
+    case WS_EVT_CONNECT:
+      {
+        // The upgrade request comes with the connect event
+        uint32_t since = resyncVersion((AsyncWebServerRequest*)arg);
+        Serial.printf("[%s %u] Connected from %s\n", server->url(), client->id(),
+                      client->remoteIP().toString().c_str());
+        portENTER_CRITICAL(&welcomeMux);
+        if(welcomeCount < WS_WELCOME_QUEUE) {
+          welcome[welcomeCount].server = server;
+          welcome[welcomeCount].id = client->id();
+          welcome[welcomeCount].since = since;
+          welcomeCount++;
+        } else {
+          welcomeOverflow = true;
+        }
+        portEXIT_CRITICAL(&welcomeMux);
+      }
       break;
-      
-    case WStype_CONNECTED:
-      Serial.printf("[%u] Connected from %s\n", num, webSocket.remoteIP(num).toString().c_str());
-      sendWebSocketUpdate(); // Send current state to new client
-      sendAntennaNameUpdate(); // Send antenna names to new client
+
+    case WS_EVT_DISCONNECT:
+      Serial.printf("[%s %u] Disconnected!\n", server->url(), client->id());
       break;
-      
-    case WStype_TEXT:
+
+    case WS_EVT_DATA:
       {
-        String message = String((char*)payload);
-        DynamicJsonDocument doc(200);
-        deserializeJson(doc, message);
-        
-        if(doc["type"] == "select") {
-          uint8_t radio = doc["radio"];
-          uint8_t antenna = doc["antenna"];
-          selectAntenna(radio, antenna);
-        }
+        // Whole messages in a single frame only; ours are a few bytes
+        AwsFrameInfo* info = (AwsFrameInfo*)arg;
+        if(!info->final || info->index != 0 || info->len != len)
+          break;
+        if(info->opcode == WS_TEXT)
+          handleJsonMessage(data, len, receivedAt);
+        else if(info->opcode == WS_BINARY && server == &wsBin && len > 0 && data[0] == WSB_SELECT)
+          handleBinarySelect(client, data, len, receivedAt);
       }
       break;
-      
+
     default:
       break;
   }
 }
 
+void sendWebSocketUpdate() {
+  stateDirty = true;
+}
+
+void sendAntennaNameUpdate() {
+  renderAntennaNames();
+  namesDirty = true;
+}
+
+void sendOTAStatus(const String& status, const String& message, uint8_t progress) {
+  portENTER_CRITICAL(&otaMux);
+  snprintf(pendingOTA.status, sizeof(pendingOTA.status), "%s", status.c_str());
+  snprintf(pendingOTA.message, sizeof(pendingOTA.message), "%s", message.c_str());
+  pendingOTA.progress = progress;
+  otaDirty = true;
+  portEXIT_CRITICAL(&otaMux);
+}
+
+void handleWebSocketBroadcasts(bool now) {
+  if(millis() - lastCleanup >= WS_CLEANUP_MS) {
+    lastCleanup = millis();
+    ws.cleanupClients();
+    wsBin.cleanupClients();
+  }
+
+  handleWelcome();
+
+  if(!stateDirty && !namesDirty && !otaDirty)
+    return;
+  if(!now && millis() - lastBroadcast < WS_BROADCAST_TICK_MS)
+    return;
+  lastBroadcast = millis();
+
+  // Flags are cleared before sending, so a change made meanwhile is
+  // picked up by the next tick. The names frame has no version; the
+  // state frame after it carries the one the names change was counted at.
+  bool namesChanged = namesDirty;
+  if(namesChanged) {
+    namesDirty = false;
+    namesVersion = ++syncVersion;
+    stateVersion = namesVersion;
+    broadcastNames();
+  }
+
+  if(stateDirty || namesChanged) {
+    stateDirty = false;
+    broadcastState();
+  }
+
+  if(otaDirty) {
+    OTAStatus ota;
+    portENTER_CRITICAL(&otaMux);
+    ota = pendingOTA;
+    otaDirty = false;
+    portEXIT_CRITICAL(&otaMux);
+
+    StaticJsonDocument<192> doc;
+    doc["type"] = "ota";
+    doc["status"] = ota.status;
+    doc["message"] = ota.message;
+    doc["progress"] = ota.progress;
+    char frame[192];
+    size_t len = serializeJson(doc, frame, sizeof(frame));
+    AsyncWebSocketMessageBuffer* buffer = ws.makeBuffer((uint8_t*)frame, len);
+    if(buffer)
+      textAllBoth(buffer);
+  }
+}
+
 void initializeWebSocket() {
-  webSocket.begin();
-  webSocket.onEvent(webSocketEvent);
+  // Boot state is version 1 of a new epoch
+  syncEpoch = esp_random() | 1;
+  for(uint8_t r = 0; r < MATRIX_RADIOS; r++) {
+    synced.antenna[r] = currentAntenna[r];
+    antennaVersion[r] = 1;
+  }
+  synced.singleRadioMode = singleRadioMode;
+  synced.antennaSwapping = antennaSwappingEnabled;
+
+  namesMutex = xSemaphoreCreateMutex();
+  renderAntennaNames();
+
+  ws.onEvent(onWebSocketEvent);
+  wsBin.onEvent(onWebSocketEvent);
+  server.addHandler(&ws);
+  server.addHandler(&wsBin);
 }
@@ -0,0 +1,122 @@
+// selectAntenna()/selectAntennas() result codes and the resulting
+// assignment, through the relay task on the native HAL
+
+#include <unity.h>
+#include "globals.h"
+#include "antenna_hardware.h"
+
+static void disconnectEveryRadio() {
+  for(uint8_t r = 0; r < MATRIX_RADIOS; r++)
+    TEST_ASSERT_EQUAL_UINT8(0, selectAntenna(r, 0));
+}
+
+void setUp() {
+  antennaSwappingEnabled = false;
+  singleRadioMode = false;
+  disconnectEveryRadio();
+}
+
+void tearDown() {
+}
+
+static void test_select_ok() {
+  TEST_ASSERT_EQUAL_UINT8(0, selectAntenna(0, 3));
+  TEST_ASSERT_EQUAL_UINT8(3, currentAntenna[0]);
+  TEST_ASSERT_EQUAL_UINT8(0, selectAntenna(1, MATRIX_ANTENNAS));
+  TEST_ASSERT_EQUAL_UINT8(MATRIX_ANTENNAS, currentAntenna[1]);
+  TEST_ASSERT_EQUAL_UINT8(0, selectAntenna(0, 0));
+  TEST_ASSERT_EQUAL_UINT8(0, currentAntenna[0]);
+}
+
+static void test_select_parameter_error() {
+  TEST_ASSERT_EQUAL_UINT8(1, selectAntenna(MATRIX_RADIOS, 1));
+  TEST_ASSERT_EQUAL_UINT8(1, selectAntenna(0, MATRIX_ANTENNAS + 1));
+  TEST_ASSERT_EQUAL_UINT8(0, currentAntenna[0]);
+}
+
+static void test_select_busy_without_swapping() {
+  TEST_ASSERT_EQUAL_UINT8(0, selectAntenna(0, 2));
+  TEST_ASSERT_EQUAL_UINT8(2, selectAntenna(1, 2));
+  TEST_ASSERT_EQUAL_UINT8(2, currentAntenna[0]);
+  TEST_ASSERT_EQUAL_UINT8(0, currentAntenna[1]);
+}
+
+static void test_select_swaps() {
+  antennaSwappingEnabled = true;
+  TEST_ASSERT_EQUAL_UINT8(0, selectAntenna(0, 2));
+  TEST_ASSERT_EQUAL_UINT8(0, selectAntenna(1, 4));
+  TEST_ASSERT_EQUAL_UINT8(0, selectAntenna(1, 2));
+  TEST_ASSERT_EQUAL_UINT8(4, currentAntenna[0]);
+  TEST_ASSERT_EQUAL_UINT8(2, currentAntenna[1]);
+}
+
+static void test_select_single_radio_mode() {
+  singleRadioMode = true;
+  TEST_ASSERT_EQUAL_UINT8(0, selectAntenna(1, 2));
+  TEST_ASSERT_EQUAL_UINT8(0, currentAntenna[1]);
+  TEST_ASSERT_EQUAL_UINT8(0, selectAntenna(0, 2));
+  TEST_ASSERT_EQUAL_UINT8(2, currentAntenna[0]);
+}
+
+static void test_disconnect_other_radios() {
+  for(uint8_t r = 0; r < MATRIX_RADIOS; r++)
+    TEST_ASSERT_EQUAL_UINT8(0, selectAntenna(r, r + 1));
+  disconnectOtherRadios();
+  TEST_ASSERT_EQUAL_UINT8(1, currentAntenna[0]);
+  for(uint8_t r = 1; r < MATRIX_RADIOS; r++)
+    TEST_ASSERT_EQUAL_UINT8(0, currentAntenna[r]);
+}
+
+static void test_batch_ok() {
+  AntennaSelection selections[] = {{0, 1}, {1, 2}};
+  TEST_ASSERT_EQUAL_UINT8(0, selectAntennas(selections, 2));
+  TEST_ASSERT_EQUAL_UINT8(1, currentAntenna[0]);
+  TEST_ASSERT_EQUAL_UINT8(2, currentAntenna[1]);
+
+  // Exchanging antennas in one batch is not a conflict
+  AntennaSelection exchange[] = {{0, 2}, {1, 1}};
+  TEST_ASSERT_EQUAL_UINT8(0, selectAntennas(exchange, 2));
+  TEST_ASSERT_EQUAL_UINT8(2, currentAntenna[0]);
+  TEST_ASSERT_EQUAL_UINT8(1, currentAntenna[1]);
+}
+
+static void test_batch_parameter_error() {
+  AntennaSelection badRadio[] = {{0, 1}, {MATRIX_RADIOS, 2}};
+  TEST_ASSERT_EQUAL_UINT8(1, selectAntennas(badRadio, 2));
+  AntennaSelection badAntenna[] = {{0, MATRIX_ANTENNAS + 1}};
+  TEST_ASSERT_EQUAL_UINT8(1, selectAntennas(badAntenna, 1));
+  AntennaSelection repeated[] = {{0, 1}, {0, 2}};
+  TEST_ASSERT_EQUAL_UINT8(1, selectAntennas(repeated, 2));
+  TEST_ASSERT_EQUAL_UINT8(0, currentAntenna[0]);
+}
+
+static void test_batch_busy() {
+  AntennaSelection shared[] = {{0, 3}, {1, 3}};
+  TEST_ASSERT_EQUAL_UINT8(2, selectAntennas(shared, 2));
+
+  // Conflict with a radio not in the batch
+  TEST_ASSERT_EQUAL_UINT8(0, selectAntenna(1, 4));
+  AntennaSelection taken[] = {{0, 4}};
+  TEST_ASSERT_EQUAL_UINT8(2, selectAntennas(taken, 1));
+  TEST_ASSERT_EQUAL_UINT8(0, currentAntenna[0]);
+  TEST_ASSERT_EQUAL_UINT8(4, currentAntenna[1]);
+}
+
+int main(int argc, char** argv) {
+  initializeHardware();
+  for(uint8_t r = 0; r < MATRIX_RADIOS; r++)
+    for(uint8_t a = 0; a < MATRIX_ANTENNAS; a++)
+      setRelaySettleMs(r, a, 0);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_select_ok);
+  RUN_TEST(test_select_parameter_error);
+  RUN_TEST(test_select_busy_without_swapping);
+  RUN_TEST(test_select_swaps);
+  RUN_TEST(test_select_single_radio_mode);
+  RUN_TEST(test_disconnect_other_radios);
+  RUN_TEST(test_batch_ok);
+  RUN_TEST(test_batch_parameter_error);
+  RUN_TEST(test_batch_busy);
+  return UNITY_END();
+}
@@ -0,0 +1,234 @@
+// MatrixSwitch break/make masks, settle ordering and one port write per
+// step, on a fake port with a manual clock
+
+#include <unity.h>
+#include <vector>
+#include "matrix_switch.h"
+
+struct PortWrite {
+  uint64_t set;
+  uint64_t clear;
+  uint64_t atUs;
+};
+
+// Logs every write; time only moves when a test advances it
+class FakeRelayPort : public RelayPort {
+public:
+  std::vector<PortWrite> writes;
+  uint64_t now = 1000;
+  uint32_t scheduledUs = 0;
+  bool timerArmed = false;
+
+  void write(uint64_t setMask, uint64_t clearMask) override {
+    writes.push_back({setMask, clearMask, now});
+  }
+  uint64_t nowUs() override { return now; }
+  void schedule(uint32_t delayUs) override {
+    scheduledUs = delayUs;
+    timerArmed = true;
+  }
+};
+
+typedef MatrixSwitch<2, 3> TestSwitch;
+
+static const uint8_t pins[2][3] = {{13, 12, 14}, {5, 18, 19}};
+#define PIN(radio, antenna) (1ULL << pins[radio][(antenna) - 1])
+
+static FakeRelayPort* port;
+static TestSwitch* matrix;
+
+// Advance the clock and fire the timer if it is due
+static void advanceUs(uint32_t us) {
+  port->now += us;
+  if(port->timerArmed && us >= port->scheduledUs) {
+    port->timerArmed = false;
+    matrix->onTimer();
+  }
+}
+
+static void applyAndSettle(uint8_t a0, uint8_t a1) {
+  const uint8_t target[2] = {a0, a1};
+  matrix->apply(target);
+  advanceUs(port->scheduledUs);
+}
+
+void setUp() {
+  port = new FakeRelayPort();
+  matrix = new TestSwitch(*port, pins);
+  matrix->reset();
+  port->writes.clear();
+}
+
+void tearDown() {
+  delete matrix;
+  delete port;
+}
+
+static void test_reset_opens_every_relay() {
+  port->writes.clear();
+  matrix->reset();
+  TEST_ASSERT_EQUAL_UINT64(0, port->writes.back().set);
+  TEST_ASSERT_EQUAL_UINT64(PIN(0, 1) | PIN(0, 2) | PIN(0, 3) | PIN(1, 1) | PIN(1, 2) | PIN(1, 3),
+                           port->writes.back().clear);
+  TEST_ASSERT_EQUAL_UINT64(0, matrix->outputMask());
+}
+
+static void test_make_without_break_is_immediate() {
+  const uint8_t target[2] = {1, 3};
+  matrix->apply(target);
+  TEST_ASSERT_FALSE(matrix->busy());
+  TEST_ASSERT_EQUAL_UINT64(PIN(0, 1) | PIN(1, 3), matrix->outputMask());
+  TEST_ASSERT_EQUAL_UINT32(1, matrix->state(0));
+  TEST_ASSERT_EQUAL_UINT32(1 << 2, matrix->state(1));
+}
+
+static void test_break_then_make_after_settle() {
+  applyAndSettle(1, 0);
+  port->writes.clear();
+
+  const uint8_t target[2] = {2, 0};
+  matrix->apply(target);
+  TEST_ASSERT_EQUAL_UINT64(PIN(0, 1), port->writes[0].clear);
+  TEST_ASSERT_EQUAL_UINT64(0, matrix->outputMask());
+  TEST_ASSERT_TRUE(matrix->busy());
+  TEST_ASSERT_EQUAL_UINT32(RELAY_DEFAULT_SETTLE_MS * 1000, port->scheduledUs);
+
+  advanceUs(RELAY_DEFAULT_SETTLE_MS * 1000);
+  TEST_ASSERT_FALSE(matrix->busy());
+  TEST_ASSERT_EQUAL_UINT64(PIN(0, 2), port->writes.back().set);
+  TEST_ASSERT_EQUAL_UINT64(PIN(0, 2), matrix->outputMask());
+
+  // Make never comes before the released relay has settled
+  SwitchTrace trace = matrix->lastTrace();
+  TEST_ASSERT_TRUE(trace.breakUs > 0);
+  TEST_ASSERT_TRUE(trace.makeUs >= trace.breakUs + RELAY_DEFAULT_SETTLE_MS * 1000);
+}
+
+static void test_longest_settle_wins() {
+  matrix->setSettleMs(0, 0, 3);
+  matrix->setSettleMs(1, 1, 20);
+  applyAndSettle(1, 2);
+
+  const uint8_t target[2] = {3, 1};
+  matrix->apply(target);
+  TEST_ASSERT_EQUAL_UINT64(PIN(0, 1) | PIN(1, 2), port->writes.back().clear);
+  TEST_ASSERT_EQUAL_UINT32(20000, port->scheduledUs);
+
+  // An early timer reschedules for the rest of the wait
+  port->timerArmed = false;
+  port->now += 5000;
+  matrix->onTimer();
+  TEST_ASSERT_TRUE(matrix->busy());
+  TEST_ASSERT_TRUE(port->timerArmed);
+  TEST_ASSERT_EQUAL_UINT32(15000, port->scheduledUs);
+  TEST_ASSERT_EQUAL_UINT64(0, matrix->outputMask());
+
+  advanceUs(15000);
+  TEST_ASSERT_EQUAL_UINT64(PIN(0, 3) | PIN(1, 1), matrix->outputMask());
+}
+
+static void test_zero_settle_makes_in_apply() {
+  for(uint8_t r = 0; r < 2; r++)
+    for(uint8_t a = 0; a < 3; a++)
+      matrix->setSettleMs(r, a, 0);
+  applyAndSettle(1, 2);
+
+  const uint8_t target[2] = {2, 1};
+  matrix->apply(target);
+  TEST_ASSERT_FALSE(matrix->busy());
+  TEST_ASSERT_EQUAL_UINT64(PIN(0, 2) | PIN(1, 1), matrix->outputMask());
+}
+
+static void test_retarget_while_make_pending() {
+  applyAndSettle(1, 0);
+
+  const uint8_t first[2] = {2, 0};
+  matrix->apply(first);
+  TEST_ASSERT_TRUE(matrix->busy());
+
+  // The second target replaces the first before anything is closed
+  port->now += 1000;
+  const uint8_t second[2] = {3, 0};
+  matrix->apply(second);
+  advanceUs(port->scheduledUs);
+  TEST_ASSERT_FALSE(matrix->busy());
+  TEST_ASSERT_EQUAL_UINT64(PIN(0, 3), matrix->outputMask());
+  for(const PortWrite& w : port->writes)
+    TEST_ASSERT_EQUAL_UINT64(0, w.set & PIN(0, 2));
+}
+
+// Every relay of a step changes in the same port write
+static void test_swap_is_one_break_and_one_make_write() {
+  applyAndSettle(1, 2);
+  port->writes.clear();
+
+  applyAndSettle(2, 1);
+  TEST_ASSERT_EQUAL(2, port->writes.size());
+  TEST_ASSERT_EQUAL_UINT64(0, port->writes[0].set);
+  TEST_ASSERT_EQUAL_UINT64(PIN(0, 1) | PIN(1, 2), port->writes[0].clear);
+  TEST_ASSERT_EQUAL_UINT64(PIN(0, 2) | PIN(1, 1), port->writes[1].set);
+  TEST_ASSERT_EQUAL_UINT64(0, port->writes[1].clear);
+  TEST_ASSERT_TRUE(port->writes[1].atUs >= port->writes[0].atUs + RELAY_DEFAULT_SETTLE_MS * 1000);
+}
+
+static void test_make_only_is_one_write() {
+  applyAndSettle(3, 1);
+  TEST_ASSERT_EQUAL(1, port->writes.size());
+  TEST_ASSERT_EQUAL_UINT64(PIN(0, 3) | PIN(1, 1), port->writes[0].set);
+  TEST_ASSERT_EQUAL_UINT64(0, port->writes[0].clear);
+}
+
+static void test_break_only_is_one_write() {
+  applyAndSettle(3, 1);
+  port->writes.clear();
+
+  applyAndSettle(0, 0);
+  TEST_ASSERT_EQUAL(1, port->writes.size());
+  TEST_ASSERT_EQUAL_UINT64(0, port->writes[0].set);
+  TEST_ASSERT_EQUAL_UINT64(PIN(0, 3) | PIN(1, 1), port->writes[0].clear);
+}
+
+static void test_unchanged_target_writes_nothing() {
+  applyAndSettle(2, 3);
+  port->writes.clear();
+
+  applyAndSettle(2, 3);
+  TEST_ASSERT_EQUAL(0, port->writes.size());
+}
+
+static void test_early_timer_writes_nothing() {
+  applyAndSettle(1, 0);
+  port->writes.clear();
+
+  const uint8_t target[2] = {2, 0};
+  matrix->apply(target);
+  port->now += 1000;
+  matrix->onTimer();
+  TEST_ASSERT_EQUAL(1, port->writes.size());
+}
+
+static void test_settle_setter_bounds() {
+  matrix->setSettleMs(0, 2, 7);
+  TEST_ASSERT_EQUAL_UINT16(7, matrix->settleMs(0, 2));
+  matrix->setSettleMs(2, 0, 9);
+  matrix->setSettleMs(0, 3, 9);
+  TEST_ASSERT_EQUAL_UINT16(0, matrix->settleMs(2, 0));
+  TEST_ASSERT_EQUAL_UINT16(RELAY_DEFAULT_SETTLE_MS, matrix->settleMs(1, 2));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_reset_opens_every_relay);
+  RUN_TEST(test_make_without_break_is_immediate);
+  RUN_TEST(test_break_then_make_after_settle);
+  RUN_TEST(test_longest_settle_wins);
+  RUN_TEST(test_zero_settle_makes_in_apply);
+  RUN_TEST(test_retarget_while_make_pending);
+  RUN_TEST(test_swap_is_one_break_and_one_make_write);
+  RUN_TEST(test_make_only_is_one_write);
+  RUN_TEST(test_break_only_is_one_write);
+  RUN_TEST(test_unchanged_target_writes_nothing);
+  RUN_TEST(test_early_timer_writes_nothing);
+  RUN_TEST(test_settle_setter_bounds);
+  return UNITY_END();
+}
@@ -0,0 +1,173 @@
+// Replies of the native serial and OTRSP parsers, and band report
+// decoding
+
+#include <unity.h>
+#include <string>
+#include "globals.h"
+#include "antenna_hardware.h"
+#include "band_index.h"
+#include "command_parser.h"
+#include "otrsp.h"
+
+// Collects what a parser prints
+class CaptureStream : public Stream {
+public:
+  std::string text;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  size_t write(uint8_t c) override { text += (char)c; return 1; }
+  size_t write(const uint8_t* buffer, size_t size) override {
+    text.append((const char*)buffer, size);
+    return size;
+  }
+  using Print::write;
+};
+
+// parseCommand() tokenizes in place and expects the lowercased line
+static std::string command(const char* line) {
+  char buffer[BUF_SIZE];
+  strncpy(buffer, line, sizeof(buffer) - 1);
+  buffer[sizeof(buffer) - 1] = '\0';
+  CaptureStream out;
+  parseCommand(buffer, out);
+  return out.text;
+}
+
+static std::string otrsp(const char* line) {
+  CaptureStream out;
+  parseOTRSPCommand(line, out);
+  return out.text;
+}
+
+void setUp() {
+  antennaSwappingEnabled = false;
+  singleRadioMode = false;
+  bandAutoSelect = false;
+  for(uint8_t a = 0; a < MATRIX_ANTENNAS; a++)
+    antennas[a].bands.clear();
+  antennas[3].bands.push_back("20m");
+  antennas[4].bands.push_back("40m");
+  rebuildBandIndex();
+  for(uint8_t r = 0; r < MATRIX_RADIOS; r++)
+    selectAntenna(r, 0);
+}
+
+void tearDown() {
+}
+
+static void test_command_set() {
+  TEST_ASSERT_EQUAL_STRING("+OK\r\n", command("set 1 3").c_str());
+  TEST_ASSERT_EQUAL_UINT8(3, currentAntenna[0]);
+  TEST_ASSERT_EQUAL_STRING("!BUSY\r\n", command("set 2 3").c_str());
+  TEST_ASSERT_EQUAL_STRING("!ERR\r\n", command("set 9 1").c_str());
+  TEST_ASSERT_EQUAL_STRING("!ERR\r\n", command("set 1").c_str());
+  TEST_ASSERT_EQUAL_STRING("+OK\r\n", command("set 1 1 2 2").c_str());
+  TEST_ASSERT_EQUAL_UINT8(1, currentAntenna[0]);
+  TEST_ASSERT_EQUAL_UINT8(2, currentAntenna[1]);
+  TEST_ASSERT_EQUAL_STRING("!BUSY\r\n", command("set 1 4 2 4").c_str());
+}
+
+static void test_command_get() {
+  command("set 2 5");
+  TEST_ASSERT_EQUAL_STRING("0\r\n", command("get 1").c_str());
+  TEST_ASSERT_EQUAL_STRING("5\r\n", command("get 2").c_str());
+  TEST_ASSERT_EQUAL_STRING("!ERR\r\n", command("get 9").c_str());
+  TEST_ASSERT_EQUAL_STRING("!ERR\r\n", command("get").c_str());
+}
+
+static void test_command_band() {
+  TEST_ASSERT_EQUAL_STRING("+OK 4\n", command("band 1 14.025").c_str());
+  TEST_ASSERT_EQUAL_UINT8(4, currentAntenna[0]);
+  // The only 20m antenna is taken by radio 1
+  TEST_ASSERT_EQUAL_STRING("!BUSY\r\n", command("band 2 20m").c_str());
+  TEST_ASSERT_EQUAL_STRING("!ERR\r\n", command("band 1 zz").c_str());
+  TEST_ASSERT_EQUAL_STRING("!ERR\r\n", command("band 9 20m").c_str());
+}
+
+static void test_command_identify_and_junk() {
+  TEST_ASSERT_EQUAL_STRING(DEVICE_NAME "\r\n", command("?").c_str());
+  TEST_ASSERT_EQUAL_STRING("", command("hello").c_str());
+  TEST_ASSERT_EQUAL_STRING("", command("").c_str());
+}
+
+static void test_otrsp_aux() {
+  TEST_ASSERT_EQUAL_STRING("", otrsp("AUX13").c_str());
+  TEST_ASSERT_EQUAL_UINT8(3, currentAntenna[0]);
+  TEST_ASSERT_EQUAL_STRING("AUX13\r", otrsp("?AUX1").c_str());
+  TEST_ASSERT_EQUAL_STRING("?AUX9\r", otrsp("?AUX9").c_str());
+}
+
+static void test_otrsp_aux_batch() {
+  // One malformed item rejects the whole batch
+  const char* malformed[] = {"AUX13x,24", "AUX1-,2", "AUX13,24x", "AUX13,", "AUX13,,24",
+                             "AUX1 3,24", "AUX13,2+4", "AUX199,24"};
+  for(const char* line : malformed) {
+    otrsp(line);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0, currentAntenna[0], line);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0, currentAntenna[1], line);
+  }
+
+  TEST_ASSERT_EQUAL_STRING("", otrsp("AUX13,24").c_str());
+  TEST_ASSERT_EQUAL_UINT8(3, currentAntenna[0]);
+  TEST_ASSERT_EQUAL_UINT8(4, currentAntenna[1]);
+}
+
+static void test_otrsp_queries() {
+  TEST_ASSERT_EQUAL_STRING("TX1\r", otrsp("?TX").c_str());
+  TEST_ASSERT_EQUAL_STRING("RX1\r", otrsp("?RX").c_str());
+  TEST_ASSERT_EQUAL_STRING("NAME" DEVICE_NAME "\r", otrsp("?NAME").c_str());
+  TEST_ASSERT_EQUAL_STRING("FW1.0.0\r", otrsp("?FW").c_str());
+  TEST_ASSERT_EQUAL_STRING("?\r", otrsp("?").c_str());
+  TEST_ASSERT_EQUAL_STRING("?BOGUS\r", otrsp("?BOGUS").c_str());
+  TEST_ASSERT_EQUAL_STRING("", otrsp("XYZZY").c_str());
+  TEST_ASSERT_EQUAL_STRING("", otrsp("").c_str());
+}
+
+static void test_otrsp_band_mode() {
+  TEST_ASSERT_EQUAL_STRING("", otrsp("BAND114.025").c_str());
+  TEST_ASSERT_EQUAL_STRING("BAND114.025\r", otrsp("?BAND1").c_str());
+  TEST_ASSERT_EQUAL_UINT8(0, currentAntenna[0]);
+  TEST_ASSERT_EQUAL_STRING("", otrsp("MODE1C").c_str());
+  TEST_ASSERT_EQUAL_STRING("MODE1C\r", otrsp("?MODE1").c_str());
+}
+
+static void test_otrsp_band_auto_select() {
+  bandAutoSelect = true;
+  otrsp("BAND27.010");
+  TEST_ASSERT_EQUAL_UINT8(5, currentAntenna[1]);
+}
+
+static void test_band_from_report() {
+  TEST_ASSERT_EQUAL_UINT8(BAND_20M, bandFromReport("20m"));
+  TEST_ASSERT_EQUAL_UINT8(BAND_20M, bandFromReport("20M"));
+  TEST_ASSERT_EQUAL_UINT8(BAND_20M, bandFromReport("14.025"));
+  TEST_ASSERT_EQUAL_UINT8(BAND_40M, bandFromReport("7.010"));
+  TEST_ASSERT_EQUAL_UINT8(BAND_80M, bandFromReport("3"));
+  TEST_ASSERT_EQUAL_UINT8(BAND_160M, bandFromReport("1"));
+  TEST_ASSERT_EQUAL_UINT8(BAND_6M, bandFromReport("50"));
+  TEST_ASSERT_EQUAL_UINT8(BAND_NONE, bandFromReport("13.9"));
+  TEST_ASSERT_EQUAL_UINT8(BAND_NONE, bandFromReport("99.9"));
+  TEST_ASSERT_EQUAL_UINT8(BAND_NONE, bandFromReport("abc"));
+  TEST_ASSERT_EQUAL_UINT8(BAND_NONE, bandFromReport(""));
+}
+
+int main(int argc, char** argv) {
+  initializeHardware();
+  for(uint8_t r = 0; r < MATRIX_RADIOS; r++)
+    for(uint8_t a = 0; a < MATRIX_ANTENNAS; a++)
+      setRelaySettleMs(r, a, 0);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_command_set);
+  RUN_TEST(test_command_get);
+  RUN_TEST(test_command_band);
+  RUN_TEST(test_command_identify_and_junk);
+  RUN_TEST(test_otrsp_aux);
+  RUN_TEST(test_otrsp_aux_batch);
+  RUN_TEST(test_otrsp_queries);
+  RUN_TEST(test_otrsp_band_mode);
+  RUN_TEST(test_otrsp_band_auto_select);
+  RUN_TEST(test_band_from_report);
+  return UNITY_END();
+}
@@ -0,0 +1,154 @@
+// Settings JSON: save/load round trip, defaults, the old antenna format
+// and rejected values. SPIFFS is a temporary directory.
+
+#include <unity.h>
+#include <SPIFFS.h>
+#include <unistd.h>
+#include "globals.h"
+#include "antenna_hardware.h"
+#include "band_index.h"
+#include "storage.h"
+#include "uart2.h"
+
+static void resetSettings() {
+  mdnsHostname = "antenna";
+  antennaSwappingEnabled = false;
+  singleRadioMode = false;
+  otrspEnabled = false;
+  otrspSerialEnabled = false;
+  bandAutoSelect = false;
+  serialBaud = UART2_DEFAULT_BAUD;
+  serialAutobaud = false;
+  for(uint8_t r = 0; r < MATRIX_RADIOS; r++)
+    for(uint8_t a = 0; a < MATRIX_ANTENNAS; a++)
+      setRelaySettleMs(r, a, RELAY_DEFAULT_SETTLE_MS);
+  for(uint8_t a = 0; a < MATRIX_ANTENNAS; a++) {
+    antennas[a].name = "";
+    antennas[a].bands.clear();
+  }
+}
+
+static void writeSettingsFile(const char* json) {
+  File file = SPIFFS.open("/settings.json", "w");
+  TEST_ASSERT_TRUE(file);
+  file.print(json);
+  file.close();
+}
+
+void setUp() {
+  SPIFFS.remove("/settings.json");
+  resetSettings();
+}
+
+void tearDown() {
+}
+
+static void test_defaults_without_file() {
+  loadSettings();
+  TEST_ASSERT_EQUAL_STRING("antenna", mdnsHostname.c_str());
+  TEST_ASSERT_EQUAL_STRING("Antenna 1", antennas[0].name.c_str());
+  TEST_ASSERT_EQUAL_STRING("Antenna " MATRIX_STR(MATRIX_ANTENNAS), antennas[MATRIX_ANTENNAS - 1].name.c_str());
+  TEST_ASSERT_EQUAL(0, antennas[0].bands.size());
+  TEST_ASSERT_EQUAL_UINT16(RELAY_DEFAULT_SETTLE_MS, getRelaySettleMs(0, 0));
+}
+
+static void test_round_trip() {
+  mdnsHostname = "shack";
+  antennaSwappingEnabled = true;
+  singleRadioMode = true;
+  otrspEnabled = true;
+  otrspSerialEnabled = true;
+  bandAutoSelect = true;
+  serialBaud = 115200;
+  serialAutobaud = true;
+  setRelaySettleMs(0, 1, 12);
+  setRelaySettleMs(MATRIX_RADIOS - 1, MATRIX_ANTENNAS - 1, 0);
+  for(uint8_t a = 0; a < MATRIX_ANTENNAS; a++)
+    antennas[a].name = "Ant \"" + String(a + 1) + "\"";
+  antennas[0].bands.push_back("20m");
+  antennas[0].bands.push_back("15m");
+  antennas[2].bands.push_back("40m");
+  TEST_ASSERT_TRUE(saveSettings());
+
+  resetSettings();
+  loadSettings();
+
+  TEST_ASSERT_EQUAL_STRING("shack", mdnsHostname.c_str());
+  TEST_ASSERT_TRUE(antennaSwappingEnabled);
+  TEST_ASSERT_TRUE(singleRadioMode);
+  TEST_ASSERT_TRUE(otrspEnabled);
+  TEST_ASSERT_TRUE(otrspSerialEnabled);
+  TEST_ASSERT_TRUE(bandAutoSelect);
+  TEST_ASSERT_EQUAL_UINT32(115200, serialBaud);
+  TEST_ASSERT_TRUE(serialAutobaud);
+  TEST_ASSERT_EQUAL_UINT16(12, getRelaySettleMs(0, 1));
+  TEST_ASSERT_EQUAL_UINT16(RELAY_DEFAULT_SETTLE_MS, getRelaySettleMs(0, 0));
+  TEST_ASSERT_EQUAL_UINT16(0, getRelaySettleMs(MATRIX_RADIOS - 1, MATRIX_ANTENNAS - 1));
+  TEST_ASSERT_EQUAL_STRING("Ant \"1\"", antennas[0].name.c_str());
+  TEST_ASSERT_EQUAL_STRING("Ant \"2\"", antennas[1].name.c_str());
+  TEST_ASSERT_EQUAL(2, antennas[0].bands.size());
+  TEST_ASSERT_EQUAL_STRING("20m", antennas[0].bands[0].c_str());
+  TEST_ASSERT_EQUAL_STRING("15m", antennas[0].bands[1].c_str());
+  TEST_ASSERT_EQUAL(0, antennas[1].bands.size());
+
+  // The band index is rebuilt from the loaded bands
+  TEST_ASSERT_EQUAL_UINT32(1 << 0, bandAntennas(BAND_20M));
+  TEST_ASSERT_EQUAL_UINT32(1 << 2, bandAntennas(BAND_40M));
+}
+
+// Long names and every band on every antenna still fit the documents
+static void test_full_settings_round_trip() {
+  for(uint8_t a = 0; a < MATRIX_ANTENNAS; a++) {
+    antennas[a].name = String("Antenna with a rather long descriptive name ") + String(a + 1);
+    for(uint8_t b = 0; b < BAND_COUNT; b++)
+      antennas[a].bands.push_back(bandName(b));
+  }
+  TEST_ASSERT_TRUE(saveSettings());
+
+  resetSettings();
+  loadSettings();
+  TEST_ASSERT_EQUAL_STRING("Antenna with a rather long descriptive name " MATRIX_STR(MATRIX_ANTENNAS),
+                           antennas[MATRIX_ANTENNAS - 1].name.c_str());
+  TEST_ASSERT_EQUAL(BAND_COUNT, antennas[MATRIX_ANTENNAS - 1].bands.size());
+  TEST_ASSERT_EQUAL_STRING(bandName(BAND_COUNT - 1), antennas[MATRIX_ANTENNAS - 1].bands[BAND_COUNT - 1].c_str());
+}
+
+static void test_old_antenna_format() {
+  writeSettingsFile("{\"antennaNames\":[\"Beam\",\"Dipole\"],"
+                    "\"antennaBands\":[[\"20m\",\"10m\"],[\"80m\"]]}");
+  loadSettings();
+  TEST_ASSERT_EQUAL_STRING("Beam", antennas[0].name.c_str());
+  TEST_ASSERT_EQUAL_STRING("Dipole", antennas[1].name.c_str());
+  TEST_ASSERT_EQUAL_STRING("Antenna 3", antennas[2].name.c_str());
+  TEST_ASSERT_EQUAL(2, antennas[0].bands.size());
+  TEST_ASSERT_EQUAL_STRING("80m", antennas[1].bands[0].c_str());
+  TEST_ASSERT_EQUAL_UINT32(1 << 1, bandAntennas(BAND_80M));
+}
+
+static void test_invalid_baud_ignored() {
+  writeSettingsFile("{\"serialBaud\":12345,\"antennaSwapping\":true}");
+  loadSettings();
+  TEST_ASSERT_EQUAL_UINT32(UART2_DEFAULT_BAUD, serialBaud);
+  TEST_ASSERT_TRUE(antennaSwappingEnabled);
+}
+
+int main(int argc, char** argv) {
+  char dir[] = "/tmp/antenna-test-XXXXXX";
+  if(!mkdtemp(dir))
+    return 1;
+  setenv("SPIFFS_DIR", dir, 1);
+  if(!initializeStorage())
+    return 1;
+
+  UNITY_BEGIN();
+  RUN_TEST(test_defaults_without_file);
+  RUN_TEST(test_round_trip);
+  RUN_TEST(test_full_settings_round_trip);
+  RUN_TEST(test_old_antenna_format);
+  RUN_TEST(test_invalid_baud_ignored);
+  int failures = UNITY_END();
+
+  SPIFFS.remove("/settings.json");
+  rmdir(dir);
+  return failures;
+}
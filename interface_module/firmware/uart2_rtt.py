@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+
+"""
+Measure OTRSP command round-trip time on the RS-485 port at each baud rate.
+
+The switch must have OTRSP enabled on RS-485 (native commands answer on
+USB, not on RS-485). For each rate the script sets the switch's rate over
+REST, reopens the local port at the same rate and times ?AUX1 queries.
+
+Usage:
+    pip install pyserial
+    python uart2_rtt.py <host> <serial-port> [--rounds 200] [--rates 9600,115200] [--out FILE.json]
+"""
+
+import argparse
+import json
+import time
+import urllib.request
+
+import serial
+
+QUERY = b"?AUX1\r"
+
+
+def percentile(values, p):
+    ordered = sorted(values)
+    index = min(len(ordered) - 1, int(round(p / 100 * (len(ordered) - 1))))
+    return ordered[index]
+
+
+def api(host, path, body=None):
+    data = json.dumps(body).encode() if body is not None else None
+    request = urllib.request.Request(f"http://{host}{path}", data=data,
+                                     headers={"Content-Type": "application/json"})
+    with urllib.request.urlopen(request, timeout=5) as response:
+        return response.read()
+
+
+def round_trip(port):
+    start = time.perf_counter()
+    port.write(QUERY)
+    reply = port.read_until(b"\r")
+    if not reply.endswith(b"\r"):
+        raise TimeoutError("no reply; is OTRSP enabled on RS-485?")
+    return (time.perf_counter() - start) * 1000
+
+
+def measure(host, device, baud, rounds):
+    api(host, "/api/serial", {"baud": baud})
+    with serial.Serial(device, baud, timeout=1) as port:
+        time.sleep(0.05)
+        port.reset_input_buffer()
+        round_trip(port)  # warm up
+        samples = [round_trip(port) for _ in range(rounds)]
+    return {
+        "baud": baud,
+        "wire_ms": len(QUERY) * 10 * 2 / baud * 1000,  # query and 6-byte reply
+        "min_ms": min(samples),
+        "p50_ms": percentile(samples, 50),
+        "p99_ms": percentile(samples, 99),
+        "max_ms": max(samples),
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description="RS-485 OTRSP round-trip time per baud rate")
+    parser.add_argument("host")
+    parser.add_argument("device")
+    parser.add_argument("--rounds", type=int, default=200)
+    parser.add_argument("--rates", help="comma-separated rates (default: all the switch supports)")
+    parser.add_argument("--out", help="write results as JSON")
+    args = parser.parse_args()
+
+    status = json.loads(api(args.host, "/api/serial"))
+    rates = [int(r) for r in args.rates.split(",")] if args.rates else status["rates"]
+
+    results = []
+    print(f"{'baud':>8} {'wire ms':>8} {'min ms':>8} {'p50 ms':>8} {'p99 ms':>8} {'max ms':>8}")
+    try:
+        for baud in rates:
+            r = measure(args.host, args.device, baud, args.rounds)
+            results.append(r)
+            print(f"{r['baud']:>8} {r['wire_ms']:>8.2f} {r['min_ms']:>8.2f} "
+                  f"{r['p50_ms']:>8.2f} {r['p99_ms']:>8.2f} {r['max_ms']:>8.2f}")
+    finally:
+        api(args.host, "/api/serial", {"baud": status["baud"]})
+
+    if args.out:
+        with open(args.out, "w") as f:
+            json.dump({"host": args.host, "rounds": args.rounds, "results": results}, f, indent=2)
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())